@@ -0,0 +1,186 @@
+#include "compressed_graph.hpp"
+#include "csr_snapshot.hpp"
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <utility>
+
+namespace {
+    void put_varint(std::vector<std::uint8_t>& out, std::uint64_t x){
+        while (x >= 0x80) { out.push_back((std::uint8_t)(x | 0x80)); x >>= 7; }
+        out.push_back((std::uint8_t)x);
+    }
+    std::uint64_t zigzag(std::int64_t d){ return ((std::uint64_t)d << 1) ^ (std::uint64_t)(d >> 63); }
+    std::int64_t unzigzag(std::uint64_t z){ return (std::int64_t)(z >> 1) ^ -(std::int64_t)(z & 1); }
+}
+
+CompressedGraph::Iterator::Iterator(const std::uint8_t* p, int u) : p_(p) {
+    left_ = (std::size_t)varint(p_);
+    if (left_) cur_ = (int)(u + unzigzag(varint(p_)));
+}
+
+// `list(u, buf)` fills buf with the neighbours of u, in any order.
+template <typename ListOf>
+void CompressedGraph::Adjacency::encode(std::size_t n, ListOf list){
+    off.assign(n + 1, 0);
+    data.clear();
+    std::vector<int> buf;
+    for (std::size_t u = 0; u < n; ++u) {
+        off[u] = data.size();
+        buf.clear();
+        list(u, buf);
+        std::sort(buf.begin(), buf.end());
+        buf.erase(std::unique(buf.begin(), buf.end()), buf.end());
+        put_varint(data, buf.size());
+        if (buf.empty()) continue;
+        put_varint(data, zigzag((std::int64_t)buf[0] - (std::int64_t)u));
+        for (std::size_t i = 1; i < buf.size(); ++i) put_varint(data, (std::uint64_t)(buf[i] - buf[i-1]));
+    }
+    off[n] = data.size();
+    data.shrink_to_fit();
+}
+
+namespace {
+    // in-neighbour lists as one CSR (counting sort over the forward lists)
+    template <typename ForEachArc>
+    std::pair<std::vector<std::uint64_t>, std::vector<int>> reverse_csr(std::size_t n, ForEachArc arcs){
+        std::vector<std::uint64_t> off(n + 1, 0);
+        arcs([&](std::size_t, int v){ ++off[(std::size_t)v + 1]; });
+        std::partial_sum(off.begin(), off.end(), off.begin());
+        std::vector<int> in(off[n]);
+        std::vector<std::uint64_t> cur(off.begin(), off.end() - 1);
+        arcs([&](std::size_t u, int v){ in[cur[(std::size_t)v]++] = (int)u; });
+        return {std::move(off), std::move(in)};
+    }
+}
+
+CompressedGraph::CompressedGraph(const Graph& g, bool with_reverse) : n(g.n), m(g.m), directed(g.directed) {
+    out_.encode(n, [&](std::size_t u, std::vector<int>& b){ b.assign(g.adj[u].begin(), g.adj[u].end()); });
+    if (with_reverse && directed) {
+        auto [off, in] = reverse_csr(n, [&](auto f){ for (std::size_t u = 0; u < n; ++u) for (int v : g.adj[u]) f(u, v); });
+        in_.encode(n, [&](std::size_t u, std::vector<int>& b){ b.assign(in.begin() + (std::ptrdiff_t)off[u], in.begin() + (std::ptrdiff_t)off[u+1]); });
+    }
+}
+
+CompressedGraph::CompressedGraph(const CsrSnapshot& s, bool with_reverse) : n(s.n()), m(s.m()), directed(s.directed()) {
+    out_.encode(n, [&](std::size_t u, std::vector<int>& b){ auto nb = s.neighbors(u); b.assign(nb.begin(), nb.end()); });
+    if (with_reverse && directed) {
+        if (s.has_reverse())
+            in_.encode(n, [&](std::size_t u, std::vector<int>& b){ auto nb = s.in_neighbors(u); b.assign(nb.begin(), nb.end()); });
+        else
+            in_ = transposed().out_;
+    }
+}
+
+std::size_t CompressedGraph::degree(std::size_t u) const {
+    const std::uint8_t* p = out_.data.data() + out_.off[u];
+    return (std::size_t)Iterator::varint(p);
+}
+
+std::size_t CompressedGraph::bytes() const {
+    return sizeof(*this) + (out_.off.capacity() + in_.off.capacity()) * sizeof(std::uint64_t)
+         + out_.data.capacity() + in_.data.capacity();
+}
+
+CompressedGraph CompressedGraph::transposed() const {
+    CompressedGraph t;
+    t.n = n; t.m = m; t.directed = directed;
+    if (!directed) { t.out_ = out_; return t; }
+    if (!in_.off.empty()) { t.out_ = in_; t.in_ = out_; return t; }
+    auto [off, in] = reverse_csr(n, [&](auto f){ for (std::size_t u = 0; u < n; ++u) for (int v : neighbors(u)) f(u, v); });
+    t.out_.encode(n, [&](std::size_t u, std::vector<int>& b){ b.assign(in.begin() + (std::ptrdiff_t)off[u], in.begin() + (std::ptrdiff_t)off[u+1]); });
+    return t;
+}
+
+Graph CompressedGraph::to_graph() const {
+    Graph g(n, directed);
+    for (std::size_t u = 0; u < n; ++u) {
+        g.adj[u].reserve(degree(u));
+        for (int v : neighbors(u)) g.adj[u].push_back(v);
+    }
+    g.m = m;
+    return g;
+}
+
+std::size_t adjacency_bytes(const Graph& g){
+    std::size_t b = sizeof(g) + g.adj.capacity() * sizeof(Graph::AdjList);
+    for (auto& a : g.adj) b += a.capacity() * sizeof(int);
+    return b;
+}
+
+// ---------- traversals ----------
+std::size_t weak_components(const CompressedGraph& g){
+    std::vector<int> parent(g.n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int x){ while (parent[x] != x) x = parent[x] = parent[parent[x]]; return x; };
+    std::size_t comps = g.n;
+    for (std::size_t u = 0; u < g.n; ++u)
+        for (int v : g.neighbors(u)) {
+            int a = find((int)u), b = find(v);
+            if (a != b) { parent[std::max(a, b)] = std::min(a, b); --comps; }
+        }
+    return comps;
+}
+
+std::size_t strong_components(const CompressedGraph& g){
+    if (!g.directed) return weak_components(g);
+    // pass 1: finishing order by iterative DFS; the stack keeps each
+    // vertex's position in its neighbour list
+    std::vector<char> vis(g.n, 0);
+    std::vector<int> order; order.reserve(g.n);
+    std::vector<std::pair<int, CompressedGraph::Iterator>> st;
+    for (std::size_t s = 0; s < g.n; ++s) {
+        if (vis[s]) continue;
+        vis[s] = 1;
+        st.emplace_back((int)s, g.neighbors(s).begin());
+        while (!st.empty()) {
+            auto& [u, it] = st.back();
+            if (it == std::default_sentinel) { order.push_back(u); st.pop_back(); continue; }
+            int v = *it; ++it;
+            if (!vis[v]) { vis[v] = 1; st.emplace_back(v, g.neighbors((std::size_t)v).begin()); }
+        }
+    }
+    // pass 2: reverse graph in decreasing finishing order
+    std::optional<CompressedGraph> own;
+    if (!g.has_reverse()) own.emplace(g.transposed());
+    auto in = [&](int u){ return own ? own->neighbors((std::size_t)u) : g.in_neighbors((std::size_t)u); };
+    std::fill(vis.begin(), vis.end(), 0);
+    std::size_t comps = 0;
+    std::vector<int> stack;
+    for (auto r = order.rbegin(); r != order.rend(); ++r) {
+        if (vis[*r]) continue;
+        ++comps;
+        vis[*r] = 1; stack.assign(1, *r);
+        while (!stack.empty()) {
+            int u = stack.back(); stack.pop_back();
+            for (int v : in(u)) if (!vis[v]) { vis[v] = 1; stack.push_back(v); }
+        }
+    }
+    return comps;
+}
+
+bool connected_ignoring_isolated(const CompressedGraph& g){
+    std::vector<char> has(g.n, 0);
+    for (std::size_t u = 0; u < g.n; ++u)
+        for (int v : g.neighbors(u)) { has[u] = 1; has[(std::size_t)v] = 1; }
+    auto start = std::find(has.begin(), has.end(), 1);
+    if (start == has.end()) return true;   // no edges
+
+    std::optional<CompressedGraph> own;
+    if (g.directed && !g.has_reverse()) own.emplace(g.transposed());
+    std::vector<char> vis(g.n);
+    std::vector<int> stack;
+    for (int pass = 0; pass < (g.directed ? 2 : 1); ++pass) {
+        std::fill(vis.begin(), vis.end(), 0);
+        int s = (int)(start - has.begin());
+        vis[(std::size_t)s] = 1; stack.assign(1, s);
+        while (!stack.empty()) {
+            int u = stack.back(); stack.pop_back();
+            auto nb = pass == 0 ? g.neighbors((std::size_t)u)
+                                : own ? own->neighbors((std::size_t)u) : g.in_neighbors((std::size_t)u);
+            for (int v : nb) if (!vis[v]) { vis[v] = 1; stack.push_back(v); }
+        }
+        for (std::size_t i = 0; i < g.n; ++i) if (has[i] && !vis[i]) return false;
+    }
+    return true;
+}
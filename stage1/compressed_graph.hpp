@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "graph.hpp"
+
+class CsrSnapshot;
+
+// Read-only graph with byte-coded adjacency (the Ligra+ "byte" codec).
+//
+// The block of vertex u is
+//   varint(degree)  zigzag-varint(v0 - u)  varint(v1 - v0) ... varint(vk - vk-1)
+// over the sorted neighbour list, found through offsets[u]. Neighbour ids of
+// sparse graphs are mostly close to each other, so a typical arc takes one or
+// two bytes instead of four, and there is no per-vertex vector header or
+// capacity slack: about 8 bytes per vertex plus 1-2 per arc, against
+// 24 + 4*deg (+ slack) for Graph::adj. Lists are decoded sequentially.
+class CompressedGraph {
+public:
+    explicit CompressedGraph(const Graph& g, bool with_reverse = false);
+    explicit CompressedGraph(const CsrSnapshot& s, bool with_reverse = false);
+
+    std::size_t n = 0, m = 0;   // as in Graph
+    bool directed = false;
+
+    // Forward iterator over the neighbours of one vertex, in increasing order.
+    class Iterator {
+    public:
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        Iterator() = default;
+        Iterator(const std::uint8_t* p, int u);
+        int operator*() const { return cur_; }
+        Iterator& operator++(){ if (--left_) cur_ += (int)varint(p_); return *this; }
+        Iterator operator++(int){ Iterator t = *this; ++*this; return t; }
+        bool operator==(std::default_sentinel_t) const { return left_ == 0; }
+    private:
+        friend class CompressedGraph;
+        static std::uint64_t varint(const std::uint8_t*& p){
+            std::uint64_t x = 0;
+            for (int shift = 0;; shift += 7) {
+                std::uint8_t b = *p++;
+                x |= (std::uint64_t)(b & 0x7f) << shift;
+                if (!(b & 0x80)) return x;
+            }
+        }
+        const std::uint8_t* p_ = nullptr;
+        std::size_t left_ = 0;
+        int cur_ = 0;
+    };
+    struct Range {
+        Iterator first;
+        Iterator begin() const { return first; }
+        std::default_sentinel_t end() const { return {}; }
+    };
+
+    Range neighbors(std::size_t u) const { return {Iterator(out_.data.data() + out_.off[u], (int)u)}; }
+    std::size_t degree(std::size_t u) const;
+    // in-neighbours: undirected graphs, or directed ones built with_reverse
+    bool has_reverse() const { return !directed || !in_.off.empty(); }
+    Range in_neighbors(std::size_t u) const {
+        const Adjacency& a = directed ? in_ : out_;
+        return {Iterator(a.data.data() + a.off[u], (int)u)};
+    }
+
+    // bytes held (offsets + coded lists, both directions)
+    std::size_t bytes() const;
+    // the same graph with every arc reversed (has_reverse() false if directed)
+    CompressedGraph transposed() const;
+    Graph to_graph() const;
+
+private:
+    struct Adjacency {
+        std::vector<std::uint64_t> off;   // n+1
+        std::vector<std::uint8_t> data;
+        template <typename ListOf> void encode(std::size_t n, ListOf list);
+    };
+    CompressedGraph() = default;
+    Adjacency out_, in_;
+};
+
+// Traversals that only need neighbour iteration; iterative, so deep graphs
+// do not exhaust the stack.
+// Weakly connected components (isolated vertices count as components).
+std::size_t weak_components(const CompressedGraph& g);
+// Strongly connected components (Kosaraju); connected components if undirected.
+std::size_t strong_components(const CompressedGraph& g);
+// Every vertex with an edge reaches every other one (strongly, if directed).
+bool connected_ignoring_isolated(const CompressedGraph& g);
+
+// Approximate bytes of a Graph's adjacency (vector headers + capacity), for
+// comparison with CompressedGraph::bytes().
+std::size_t adjacency_bytes(const Graph& g);
@@ -0,0 +1,142 @@
+#include "csr_snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr std::uint64_t kFnvBasis = 1469598103934665603ULL, kFnvPrime = 1099511628211ULL;
+
+    void fnv(std::uint64_t& h, const void* p, std::size_t len){
+        auto* b = static_cast<const unsigned char*>(p);
+        for (std::size_t i = 0; i < len; ++i) { h ^= b[i]; h *= kFnvPrime; }
+    }
+    std::size_t pad8(std::size_t bytes){ return (bytes + 7) & ~std::size_t(7); }
+
+    // buffered writer that also checksums what it writes
+    struct Out {
+        std::FILE* f;
+        std::uint64_t h = kFnvBasis;
+        bool ok = true;
+        void put(const void* p, std::size_t len){
+            fnv(h, p, len);
+            ok = ok && std::fwrite(p, 1, len, f) == len;
+        }
+        void pad(std::size_t written){
+            static const char zeros[8] = {};
+            put(zeros, pad8(written) - written);
+        }
+    };
+
+    // CSR arrays of one direction: offsets over adj lists
+    template <typename Adj>
+    void put_csr(Out& o, const Adj& adj){
+        std::uint64_t off = 0;
+        o.put(&off, sizeof off);
+        for (auto& a : adj) { off += a.size(); o.put(&off, sizeof off); }
+        for (auto& a : adj) if (!a.empty()) o.put(a.data(), a.size() * sizeof(int));
+        o.pad((std::size_t)off * sizeof(int));
+    }
+}
+
+bool write_snapshot(const Graph& g, const std::string& path, bool with_reverse, std::string& err){
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) { err = "cannot create " + tmp + ": " + std::strerror(errno); return false; }
+
+    SnapshotHeader h{};
+    std::memcpy(h.magic, SnapshotHeader::kMagic, sizeof h.magic);
+    h.version = SnapshotHeader::kVersion;
+    h.flags = (g.directed ? SnapshotHeader::kDirected : 0) | (with_reverse ? SnapshotHeader::kHasReverse : 0);
+    h.n = g.n; h.m = g.m;
+    for (auto& a : g.adj) h.arcs += a.size();
+
+    Out o{f};
+    o.ok = std::fwrite(&h, sizeof h, 1, f) == 1;   // checksum patched in below
+    put_csr(o, g.adj);
+    if (with_reverse) {
+        std::vector<std::vector<int>> radj(g.n);
+        for (std::size_t u = 0; u < g.n; ++u) for (int v : g.adj[u]) radj[v].push_back((int)u);
+        put_csr(o, radj);
+    }
+    h.checksum = o.h;
+    bool ok = o.ok && std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof h, 1, f) == 1;
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        err = "cannot write " + path + ": " + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<CsrSnapshot> CsrSnapshot::open(const std::string& path, std::string& err, bool verify){
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { err = "cannot open " + path + ": " + std::strerror(errno); return nullptr; }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (std::size_t)st.st_size < sizeof(SnapshotHeader)) {
+        ::close(fd); err = path + ": not a graph snapshot"; return nullptr;
+    }
+    std::size_t size = (std::size_t)st.st_size;
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) { err = "cannot map " + path + ": " + std::strerror(errno); return nullptr; }
+
+    std::unique_ptr<CsrSnapshot> s(new CsrSnapshot());
+    s->base_ = base; s->size_ = size;
+    s->hdr_ = static_cast<const SnapshotHeader*>(base);
+    const SnapshotHeader& h = *s->hdr_;
+    if (std::memcmp(h.magic, SnapshotHeader::kMagic, sizeof h.magic) != 0) { err = path + ": not a graph snapshot"; return nullptr; }
+    if (h.version != SnapshotHeader::kVersion) { err = path + ": unsupported snapshot version " + std::to_string(h.version); return nullptr; }
+
+    // sizes first, so a truncated or hostile header cannot send us out of the mapping
+    std::size_t one = 8 * (std::size_t)(h.n + 1) + pad8(4 * (std::size_t)h.arcs);
+    bool rev = h.flags & SnapshotHeader::kHasReverse;
+    if (h.n >= (1ULL << 31) || h.arcs >= (1ULL << 40) || sizeof h + (rev ? 2 : 1) * one != size) {
+        err = path + ": truncated or corrupt snapshot"; return nullptr;
+    }
+    auto* p = static_cast<const char*>(base) + sizeof h;
+    s->off_ = reinterpret_cast<const std::uint64_t*>(p);
+    s->nbr_ = reinterpret_cast<const int*>(p + 8 * (h.n + 1));
+    if (rev) {
+        s->roff_ = reinterpret_cast<const std::uint64_t*>(p + one);
+        s->rnbr_ = reinterpret_cast<const int*>(p + one + 8 * (h.n + 1));
+    }
+    // offsets must be monotone and end at arcs, neighbours in range and no
+    // self-loops (Graph never has one; the Euler kernels lay out two slots
+    // per undirected edge): checked on every open, since the accessors and
+    // to_graph() trust them
+    for (int pass = 0; pass < (rev ? 2 : 1); ++pass) {
+        const std::uint64_t* off = pass ? s->roff_ : s->off_;
+        const int* nbr = pass ? s->rnbr_ : s->nbr_;
+        if (off[0] != 0 || off[h.n] != h.arcs) { err = path + ": corrupt offsets"; return nullptr; }
+        for (std::uint64_t u = 0; u < h.n; ++u) if (off[u] > off[u+1]) { err = path + ": corrupt offsets"; return nullptr; }
+        for (std::uint64_t u = 0; u < h.n; ++u)
+            for (std::uint64_t i = off[u]; i < off[u+1]; ++i) {
+                if (nbr[i] < 0 || (std::uint64_t)nbr[i] >= h.n) { err = path + ": neighbour out of range"; return nullptr; }
+                if ((std::uint64_t)nbr[i] == u) { err = path + ": self-loop at vertex " + std::to_string(u); return nullptr; }
+            }
+    }
+    if (verify) {
+        std::uint64_t sum = kFnvBasis;
+        fnv(sum, p, size - sizeof h);
+        if (sum != h.checksum) { err = path + ": checksum mismatch"; return nullptr; }
+    }
+    return s;
+}
+
+CsrSnapshot::~CsrSnapshot(){ if (base_) munmap(base_, size_); }
+
+Graph CsrSnapshot::to_graph() const {
+    Graph g(n(), directed());
+    for (std::size_t u = 0; u < n(); ++u) {
+        auto nb = neighbors(u);
+        g.adj[u].assign(nb.begin(), nb.end());
+    }
+    g.m = m();
+    return g;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include "graph.hpp"
+
+// On-disk CSR snapshot of a Graph, read in place through mmap.
+//
+//   SnapshotHeader                      64 bytes
+//   offsets      uint64[n+1]            out-neighbours of u: neighbors[offsets[u] .. offsets[u+1])
+//   neighbors    int32[arcs]            padded to a multiple of 8 bytes
+//   [roffsets    uint64[n+1]]           reverse index (in-neighbours), if kHasReverse
+//   [rneighbors  int32[arcs]]           padded likewise
+//
+// Integers are stored in host byte order (a snapshot from another endianness
+// fails the version check). An undirected graph stores both directions of
+// every edge, exactly as Graph::adj does; `m` is Graph::m. The checksum is
+// FNV-1a 64 over everything after the header.
+struct SnapshotHeader {
+    static constexpr char kMagic[8] = {'G','R','A','P','H','C','S','R'};
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::uint32_t kDirected = 1, kHasReverse = 2;   // flags
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t n, m, arcs;
+    std::uint64_t checksum;
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(SnapshotHeader) == 64);
+
+// Writes `g` to `path` (via a temporary file renamed into place). false with
+// `err` set on an I/O error.
+bool write_snapshot(const Graph& g, const std::string& path, bool with_reverse, std::string& err);
+
+// Read-only view of a mapped snapshot. Neighbour lists point into the
+// mapping, so opening costs one mmap however large the file is, and every
+// process mapping the same file shares its page cache.
+class CsrSnapshot {
+public:
+    // nullptr with `err` set if the file is missing, truncated or malformed
+    // (sizes, offsets, neighbour ranges and self-loops are always checked);
+    // verify also checks the checksum.
+    static std::unique_ptr<CsrSnapshot> open(const std::string& path, std::string& err, bool verify = true);
+    ~CsrSnapshot();
+    CsrSnapshot(const CsrSnapshot&) = delete;
+    CsrSnapshot& operator=(const CsrSnapshot&) = delete;
+
+    std::size_t n() const { return (std::size_t)hdr_->n; }
+    std::size_t m() const { return (std::size_t)hdr_->m; }
+    bool directed() const { return hdr_->flags & SnapshotHeader::kDirected; }
+    bool has_reverse() const { return hdr_->flags & SnapshotHeader::kHasReverse; }
+    std::uint64_t checksum() const { return hdr_->checksum; }
+    std::size_t file_bytes() const { return size_; }
+
+    std::span<const int> neighbors(std::size_t u) const { return {nbr_ + off_[u], nbr_ + off_[u+1]}; }
+    // in-neighbours; has_reverse() only
+    std::span<const int> in_neighbors(std::size_t u) const { return {rnbr_ + roff_[u], rnbr_ + roff_[u+1]}; }
+
+    // an owning Graph with the same adjacency (for code that needs one)
+    Graph to_graph() const;
+
+private:
+    CsrSnapshot() = default;
+    void* base_ = nullptr;
+    std::size_t size_ = 0;
+    const SnapshotHeader* hdr_ = nullptr;
+    const std::uint64_t *off_ = nullptr, *roff_ = nullptr;
+    const int *nbr_ = nullptr, *rnbr_ = nullptr;
+};
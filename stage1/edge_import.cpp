@@ -0,0 +1,377 @@
+#include "edge_import.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using Edge = std::pair<long long, long long>;
+
+// ---- scanning ----
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    void skip_blanks(){ while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p; }
+    bool at_eol() { skip_blanks(); return p >= end || *p == '\n'; }
+    void next_line(){
+        const void* nl = std::memchr(p, '\n', (std::size_t)(end - p));
+        p = nl ? static_cast<const char*>(nl) + 1 : end;
+    }
+    // non-negative decimal; false (p unchanged past blanks) if none here or
+    // if it does not fit a long long
+    bool read(long long& v){
+        skip_blanks();
+        if (p >= end || (unsigned)(*p - '0') > 9) return false;
+        const char* q = p;
+        long long x = 0;
+        for (; q < end && (unsigned)(*q - '0') <= 9; ++q) {
+            int d = *q - '0';
+            if (x > (std::numeric_limits<long long>::max() - d) / 10) return false;
+            x = x * 10 + d;
+        }
+        p = q; v = x;
+        return true;
+    }
+};
+
+// 1-based line number of `at` (only used for error messages)
+std::size_t line_of(const char* base, const char* at){
+    return 1 + (std::size_t)std::count(base, at, '\n');
+}
+
+template <typename F>
+void parallel(unsigned threads, F fn){
+    std::vector<std::thread> ts;
+    for (unsigned t = 1; t < threads; ++t) ts.emplace_back(fn, t);
+    fn(0u);
+    for (auto& t : ts) t.join();
+}
+
+// [begin, end) of chunk t, both at line starts
+std::pair<const char*, const char*> chunk(const char* data, std::size_t size, unsigned t, unsigned threads){
+    auto start = [&](unsigned k) -> const char* {
+        if (k == 0) return data;
+        if (k >= threads) return data + size;
+        Cursor c{data + size * k / threads - 1, data + size};
+        c.next_line();
+        return c.p;
+    };
+    return {start(t), start(t + 1)};
+}
+
+struct Mapping {
+    void* base = MAP_FAILED;
+    std::size_t size = 0;
+    ~Mapping(){ if (base != MAP_FAILED && size) munmap(base, size); }
+    const char* data() const { return static_cast<const char*>(base); }
+};
+
+struct Header {           // what the sequential header pass found
+    const char* body = nullptr;   // first byte after the header
+    long long n = -1;             // DIMACS / METIS vertex count
+    int metis_skip = 0;           // METIS: leading ints per line to skip (size, weights)
+    bool metis_edge_w = false;
+};
+
+bool read_header(EdgeFormat f, const char* data, std::size_t size, Header& h, std::string& err){
+    Cursor c{data, data + size};
+    h.body = data;
+    if (f == EdgeFormat::Snap) return true;
+    while (c.p < c.end) {
+        const char* line = c.p;
+        c.skip_blanks();
+        char ch = c.p < c.end ? *c.p : '\n';
+        if (f == EdgeFormat::Dimacs) {
+            if (ch == 'c' || ch == '\n') { c.next_line(); continue; }
+            if (ch != 'p') { err = "line " + std::to_string(line_of(data, line)) + ": expected DIMACS 'p' line"; return false; }
+            ++c.p;
+            while (c.p < c.end && (*c.p == ' ' || *c.p == '\t')) ++c.p;
+            while (c.p < c.end && std::isalpha((unsigned char)*c.p)) ++c.p;   // kind: edge, sp, col, ...
+            long long n, m;
+            if (!c.read(n) || !c.read(m)) { err = "line " + std::to_string(line_of(data, line)) + ": bad DIMACS 'p' line"; return false; }
+            h.n = n;
+            c.next_line();
+            h.body = c.p;
+            return true;
+        }
+        // METIS
+        if (ch == '%') { c.next_line(); continue; }
+        long long n, m, fmt = 0, ncon = 1;
+        if (!c.read(n) || !c.read(m)) { err = "line " + std::to_string(line_of(data, line)) + ": bad METIS header"; return false; }
+        const char* fp = c.p;
+        if (c.read(fmt)) {
+            c.skip_blanks();
+            std::string digits(fp, c.p);
+            digits.erase(0, digits.find_first_not_of(" \t"));
+            while (!digits.empty() && (digits.back() == ' ' || digits.back() == '\t' || digits.back() == '\r')) digits.pop_back();
+            digits = std::string(3 - std::min<std::size_t>(3, digits.size()), '0') + digits;   // "abc": sizes, vertex w, edge w
+            c.read(ncon);
+            h.metis_skip = (digits[0] == '1' ? 1 : 0) + (digits[1] == '1' ? (int)ncon : 0);
+            h.metis_edge_w = digits[2] == '1';
+        }
+        h.n = n;
+        c.next_line();
+        h.body = c.p;
+        return true;
+    }
+    err = f == EdgeFormat::Dimacs ? "no DIMACS 'p' line" : "no METIS header";
+    return false;
+}
+
+// Parses one chunk into `out`; `first_vertex` is the METIS vertex of its first
+// non-comment line. Returns an error position or nullptr.
+const char* parse_chunk(EdgeFormat f, const Header& h, const char* b, const char* e,
+                        long long first_vertex, std::vector<Edge>& out){
+    Cursor c{b, e};
+    long long vertex = first_vertex;
+    while (c.p < c.end) {
+        const char* line = c.p;
+        c.skip_blanks();
+        char ch = c.p < c.end ? *c.p : '\n';
+        if (f == EdgeFormat::Snap) {
+            if (ch == '#' || ch == '%' || ch == '\n') { c.next_line(); continue; }
+            long long u, v;
+            if (!c.read(u) || !c.read(v)) return line;
+            if (u != v) out.emplace_back(u, v);
+        } else if (f == EdgeFormat::Dimacs) {
+            if (ch == 'c' || ch == 'p' || ch == '\n') { c.next_line(); continue; }
+            if (ch != 'e' && ch != 'a') return line;
+            ++c.p;
+            long long u, v;
+            if (!c.read(u) || !c.read(v) || u < 1 || v < 1 || u > h.n || v > h.n) return line;
+            if (u != v) out.emplace_back(u - 1, v - 1);
+        } else {
+            if (ch == '%') { c.next_line(); continue; }
+            if (vertex >= h.n) { if (c.at_eol()) { c.next_line(); continue; } return line; }
+            long long skip;
+            for (int k = 0; k < h.metis_skip; ++k) if (!c.read(skip)) return line;
+            long long v, w;
+            while (c.read(v)) {
+                if (v < 1 || v > h.n) return line;
+                if (h.metis_edge_w && !c.read(w)) return line;
+                if (v - 1 != vertex) out.emplace_back(vertex, v - 1);
+            }
+            ++vertex;
+        }
+        if (!c.at_eol()) {
+            if (f == EdgeFormat::Metis) return line;
+            // SNAP / DIMACS: trailing columns (weights, timestamps) are ignored
+        }
+        c.next_line();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+const char* edge_format_name(EdgeFormat f){
+    switch (f) {
+        case EdgeFormat::Snap:   return "snap";
+        case EdgeFormat::Dimacs: return "dimacs";
+        case EdgeFormat::Metis:  return "metis";
+        default:                 return "auto";
+    }
+}
+
+bool parse_edge_format(const std::string& s, EdgeFormat& out){
+    for (EdgeFormat f : {EdgeFormat::Auto, EdgeFormat::Snap, EdgeFormat::Dimacs, EdgeFormat::Metis})
+        if (s == edge_format_name(f)) { out = f; return true; }
+    return false;
+}
+
+EdgeFormat detect_edge_format(const std::string& path, const char* data, std::size_t size){
+    auto ends = [&](const char* ext){ std::size_t k = std::strlen(ext); return path.size() >= k && path.compare(path.size() - k, k, ext) == 0; };
+    if (ends(".graph") || ends(".metis")) return EdgeFormat::Metis;
+    if (ends(".gr") || ends(".dimacs") || ends(".col")) return EdgeFormat::Dimacs;
+    Cursor c{data, data + size};
+    while (c.p < c.end) {
+        c.skip_blanks();
+        char ch = c.p < c.end ? *c.p : '\n';
+        if (ch == '#' || ch == '%' || ch == '\n') { c.next_line(); continue; }
+        if (ch == 'c') { c.next_line(); continue; }   // DIMACS comment (SNAP lines start with a digit)
+        return ch == 'p' ? EdgeFormat::Dimacs : EdgeFormat::Snap;
+    }
+    return EdgeFormat::Snap;
+}
+
+std::shared_ptr<Graph> import_edge_file(const std::string& path, const ImportOptions& opts,
+                                        ImportStats& stats, std::string& err){
+    auto t0 = std::chrono::steady_clock::now();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { err = "cannot open " + path + ": " + std::strerror(errno); return nullptr; }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) { ::close(fd); err = "cannot stat " + path; return nullptr; }
+    Mapping map;
+    map.size = (std::size_t)st.st_size;
+    if (map.size) map.base = mmap(nullptr, map.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map.size && map.base == MAP_FAILED) { err = "cannot map " + path + ": " + std::strerror(errno); return nullptr; }
+    if (map.size) madvise(map.base, map.size, MADV_SEQUENTIAL);
+    const char* data = map.size ? map.data() : "";
+
+    EdgeFormat f = opts.format == EdgeFormat::Auto ? detect_edge_format(path, data, map.size) : opts.format;
+    const bool directed = f == EdgeFormat::Metis ? false : opts.directed;
+    Header h;
+    if (!read_header(f, data, map.size, h, err)) { err = path + ": " + err; return nullptr; }
+    // the header's n sizes the Graph before any edge is read: ids must fit an
+    // int, and past 1Mi the count must stay in proportion to the file (a
+    // METIS vertex takes a line, a DIMACS edge line names at most two new ones)
+    if (h.n >= (1LL << 31) - 1 || (std::size_t)std::max(h.n, 0LL) > map.size + (1u << 20)) {
+        err = path + ": header claims " + std::to_string(h.n) + " vertices for " + std::to_string(map.size) + " bytes";
+        return nullptr;
+    }
+
+    const std::size_t body = (std::size_t)(data + map.size - h.body);
+    unsigned T = opts.threads ? opts.threads : std::max(1u, std::thread::hardware_concurrency());
+    T = (unsigned)std::max<std::size_t>(1, std::min<std::size_t>(T, body / (1u << 16) + 1));   // >= 64 KiB a chunk
+    stats = ImportStats{};
+    stats.format = f; stats.bytes = map.size; stats.threads = T;
+
+    // METIS: vertex index of each chunk's first line = non-comment lines before it
+    std::vector<long long> first_vertex(T + 1, 0);
+    if (f == EdgeFormat::Metis) {
+        parallel(T, [&](unsigned t){
+            auto [b, e] = chunk(h.body, body, t, T);
+            long long lines = 0;
+            for (Cursor c{b, e}; c.p < c.end; c.next_line()) { c.skip_blanks(); lines += !(c.p < c.end && *c.p == '%'); }
+            first_vertex[t + 1] = lines;
+        });
+        for (unsigned t = 0; t < T; ++t) first_vertex[t + 1] += first_vertex[t];
+    }
+
+    // 1) parse
+    std::vector<std::vector<Edge>> parts(T);
+    std::vector<const char*> bad(T, nullptr);
+    parallel(T, [&](unsigned t){
+        auto [b, e] = chunk(h.body, body, t, T);
+        parts[t].reserve((std::size_t)(e - b) / 12 + 16);
+        bad[t] = parse_chunk(f, h, b, e, first_vertex[t], parts[t]);
+    });
+    for (auto* b : bad)
+        if (b) { err = path + ": line " + std::to_string(line_of(data, b)) + ": cannot parse '"
+                       + std::string(b, std::find(b, data + map.size, '\n')).substr(0, 60) + "'"; return nullptr; }
+    for (auto& p : parts) stats.edges_read += p.size();
+
+    // 2) vertex ids: DIMACS / METIS are dense already; SNAP ids are mapped
+    //    to 0..n-1 in increasing order (or kept, with n = max + 1)
+    std::size_t n = 0;
+    if (h.n >= 0) n = (std::size_t)h.n;
+    else {
+        long long max_id = -1;
+        for (auto& p : parts) for (auto& [u, v] : p) max_id = std::max({max_id, u, v});
+        if (!opts.relabel) {
+            if (max_id >= (1LL << 31) - 1) { err = path + ": vertex id too large without relabelling"; return nullptr; }
+            n = (std::size_t)(max_id + 1);
+        } else if (max_id < (1LL << 31) - 1 && (std::size_t)max_id < 8 * stats.edges_read + 1024) {
+            // id range comparable to the edge count: direct index, no sort
+            std::vector<int> index((std::size_t)max_id + 1, 0);
+            parallel(T, [&](unsigned t){
+                for (auto& [u, v] : parts[t]) {
+                    std::atomic_ref<int>(index[(std::size_t)u]).store(1, std::memory_order_relaxed);
+                    std::atomic_ref<int>(index[(std::size_t)v]).store(1, std::memory_order_relaxed);
+                }
+            });
+            std::vector<long long> ids;
+            for (std::size_t id = 0; id < index.size(); ++id)
+                if (index[id]) { index[id] = (int)ids.size(); ids.push_back((long long)id); }
+            n = ids.size();
+            if (n != index.size()) {
+                parallel(T, [&](unsigned t){ for (auto& [u, v] : parts[t]) { u = index[(std::size_t)u]; v = index[(std::size_t)v]; } });
+                stats.labels = std::move(ids);
+            }
+        } else {
+            // sparse ids: sorted unique list, binary search
+            std::vector<long long> ids;
+            ids.reserve(2 * stats.edges_read);
+            for (auto& p : parts) for (auto& [u, v] : p) { ids.push_back(u); ids.push_back(v); }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            if (ids.size() >= (1ULL << 31)) { err = path + ": too many vertices"; return nullptr; }
+            n = ids.size();
+            parallel(T, [&](unsigned t){
+                for (auto& [u, v] : parts[t]) {
+                    u = std::lower_bound(ids.begin(), ids.end(), u) - ids.begin();
+                    v = std::lower_bound(ids.begin(), ids.end(), v) - ids.begin();
+                }
+            });
+            stats.labels = std::move(ids);
+        }
+    }
+
+    // 3) CSR by counting sort. Thread o owns vertices [n*o/T, n*(o+1)/T):
+    //    every thread first buckets its arcs by owner, then each owner counts,
+    //    prefix-sums and scatters its own range with plain stores (an atomic
+    //    cursor per vertex costs several times more than the scatter itself)
+    using Arc = std::pair<int, int>;
+    auto first = [&](unsigned o){ return n * o / T; };
+    auto owner = [&](std::size_t u){
+        unsigned o = (unsigned)(u * T / std::max<std::size_t>(n, 1));
+        while (o + 1 < T && first(o + 1) <= u) ++o;
+        while (o > 0 && first(o) > u) --o;
+        return o;
+    };
+    std::vector<std::vector<std::vector<Arc>>> bucket(T, std::vector<std::vector<Arc>>(T));
+    parallel(T, [&](unsigned t){
+        std::vector<std::size_t> cnt(T, 0);
+        for (auto& [u, v] : parts[t]) { ++cnt[owner((std::size_t)u)]; if (!directed) ++cnt[owner((std::size_t)v)]; }
+        for (unsigned o = 0; o < T; ++o) bucket[t][o].reserve(cnt[o]);
+        for (auto& [u, v] : parts[t]) {
+            bucket[t][owner((std::size_t)u)].emplace_back((int)u, (int)v);
+            if (!directed) bucket[t][owner((std::size_t)v)].emplace_back((int)v, (int)u);
+        }
+        std::vector<Edge>().swap(parts[t]);
+    });
+    std::vector<std::uint64_t> off(n + 1, 0);
+    std::vector<std::uint64_t> base(T + 1, 0);
+    parallel(T, [&](unsigned o){
+        for (unsigned t = 0; t < T; ++t) {
+            for (auto& [u, v] : bucket[t][o]) ++off[(std::size_t)u];   // degree, for now
+            base[o + 1] += bucket[t][o].size();
+        }
+    });
+    for (unsigned o = 0; o < T; ++o) base[o + 1] += base[o];
+    off[n] = base[T];
+    std::vector<int> nbr(base[T]);
+    parallel(T, [&](unsigned o){
+        std::uint64_t at = base[o];
+        for (std::size_t u = first(o); u < first(o + 1); ++u) { std::uint64_t d = off[u]; off[u] = at; at += d; }
+        std::vector<std::uint64_t> cursor(off.begin() + (std::ptrdiff_t)first(o), off.begin() + (std::ptrdiff_t)first(o + 1));
+        for (unsigned t = 0; t < T; ++t) {
+            for (auto& [u, v] : bucket[t][o]) nbr[cursor[(std::size_t)u - first(o)]++] = v;
+            std::vector<Arc>().swap(bucket[t][o]);
+        }
+    });
+
+    // 4) per-vertex sort + dedup straight into the Graph's lists
+    auto g = std::make_shared<Graph>(n, directed);
+    std::vector<std::size_t> arcs(T, 0);
+    parallel(T, [&](unsigned t){
+        for (std::size_t u = n * t / T; u < n * (t + 1) / T; ++u) {
+            int* b = nbr.data() + off[u];
+            int* e = nbr.data() + off[u + 1];
+            std::sort(b, e);
+            e = std::unique(b, e);
+            g->adj[u].assign(b, e);
+            arcs[t] += (std::size_t)(e - b);
+        }
+    });
+    std::size_t total = 0;
+    for (auto a : arcs) total += a;
+    g->m = directed ? total : total / 2;
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return g;
+}
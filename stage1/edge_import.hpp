@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+
+// Parallel importer for edge-list files.
+//
+//   SNAP    "u v" per line (extra columns ignored), '#' or '%' comments;
+//           ids may be sparse 64-bit values and are relabelled to 0..n-1
+//           in increasing order
+//   DIMACS  "c" comments, "p <kind> <n> <m>", then "e u v" or "a u v [w]"
+//           lines with 1-based ids
+//   METIS   '%' comments, "<n> <m> [fmt [ncon]]", then line i lists the
+//           1-based neighbours of vertex i (vertex sizes / weights and edge
+//           weights skipped according to fmt)
+//
+// The file is mapped and cut at newline boundaries into one chunk per thread;
+// each thread scans its chunk with a hand-rolled integer parser. The CSR is
+// built with a parallel counting sort (arcs bucketed by owning thread, then
+// per-range degree counts, prefix sum and scatter), then every adjacency list is sorted and deduplicated, so
+// the Graph has the same invariants as one built with add_edge (no self
+// loops, no duplicates; undirected edges stored both ways).
+enum class EdgeFormat { Auto, Snap, Dimacs, Metis };
+
+struct ImportOptions {
+    EdgeFormat format = EdgeFormat::Auto;
+    bool directed = false;     // METIS graphs are always undirected
+    unsigned threads = 0;      // 0 = hardware threads
+    bool relabel = true;       // SNAP: dense ids; false keeps them (n = max id + 1)
+};
+
+struct ImportStats {
+    EdgeFormat format = EdgeFormat::Auto;   // as detected
+    std::size_t bytes = 0, edges_read = 0;
+    unsigned threads = 0;
+    double seconds = 0;
+    std::vector<long long> labels;          // SNAP relabelling: original id of vertex i
+};
+
+// From the extension (.graph/.metis, .gr/.dimacs/.col) or the first
+// non-comment line ("p ..." is DIMACS); SNAP otherwise.
+EdgeFormat detect_edge_format(const std::string& path, const char* data, std::size_t size);
+bool parse_edge_format(const std::string& s, EdgeFormat& out);   // "auto|snap|dimacs|metis"
+const char* edge_format_name(EdgeFormat f);
+
+// nullptr with `err` set (with a line number where there is one) on failure.
+std::shared_ptr<Graph> import_edge_file(const std::string& path, const ImportOptions& opts,
+                                        ImportStats& stats, std::string& err);
@@ -6,9 +6,11 @@
 // Adjacency-list graph with optional directed edges.
 // Guarantees: ignores self-loops; avoids duplicates.
 struct Graph {
+    using AdjList = std::vector<int>;
+
     std::size_t n{};
     bool directed{false};
-    std::vector<std::vector<int>> adj; // 0..n-1
+    std::vector<AdjList> adj;          // 0..n-1
     std::size_t m{};                   // logical edge/arc count
 
     explicit Graph(std::size_t n_, bool directed_ = false);
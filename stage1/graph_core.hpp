@@ -0,0 +1,163 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "graph.hpp"
+
+// Read-only CSR copy of a Graph, specialised at compile time on direction
+// and on the integer widths of vertex ids (Id) and list offsets (Off).
+//
+// Graph stays the mutable, runtime-typed builder; kernels that only read
+// (SCC, Euler) freeze it first and are instantiated per layout, so their
+// inner loops carry no `directed` test and stream 2-byte ids for graphs of
+// up to 65536 vertices instead of 4-byte ints. dispatch() picks the
+// narrowest layout that fits n and the arc count:
+//
+//   Id   uint16_t  n <= 2^16      Off  uint32_t  arcs < 2^32
+//        uint32_t  n <= 2^32           uint64_t  otherwise
+//        uint64_t  otherwise
+//
+// Neighbour lists keep Graph::adj order, so traversals visit vertices in the
+// same order as on the Graph itself.
+namespace core {
+
+template <bool Directed, typename Id, typename Off>
+struct Csr {
+    static constexpr bool directed = Directed;
+    using id_type = Id;
+    using off_type = Off;
+
+    std::size_t n = 0, m = 0;
+    std::pmr::vector<Off> off;   // n+1
+    std::pmr::vector<Id> nbr;    // arcs; undirected graphs hold both directions
+
+    explicit Csr(std::pmr::memory_resource* mr = std::pmr::get_default_resource()) : off(mr), nbr(mr) {}
+
+    std::span<const Id> neighbors(std::size_t u) const { return {nbr.data() + off[u], nbr.data() + off[u + 1]}; }
+    std::size_t degree(std::size_t u) const { return (std::size_t)(off[u + 1] - off[u]); }
+    std::size_t arcs() const { return nbr.size(); }
+    std::size_t bytes() const { return off.size() * sizeof(Off) + nbr.size() * sizeof(Id); }
+};
+
+template <bool D, typename Id, typename Off>
+Csr<D, Id, Off> freeze(const Graph& g, std::pmr::memory_resource* mr = std::pmr::get_default_resource()){
+    Csr<D, Id, Off> c(mr);
+    c.n = g.n; c.m = g.m;
+    c.off.resize(g.n + 1);
+    std::size_t arcs = 0;
+    for (std::size_t u = 0; u < g.n; ++u) { c.off[u] = (Off)arcs; arcs += g.adj[u].size(); }
+    c.off[g.n] = (Off)arcs;
+    c.nbr.resize(arcs);
+    Id* out = c.nbr.data();
+    for (std::size_t u = 0; u < g.n; ++u)
+        for (int v : g.adj[u]) *out++ = (Id)v;
+    return c;
+}
+
+// in-neighbour lists (for an undirected graph, a copy), from c's resource
+template <bool D, typename Id, typename Off>
+Csr<D, Id, Off> transpose(const Csr<D, Id, Off>& c){
+    if constexpr (!D) return c;
+    else {
+        Csr<D, Id, Off> t(c.off.get_allocator().resource());
+        t.n = c.n; t.m = c.m;
+        t.off.assign(c.n + 1, 0);
+        for (Id v : c.nbr) ++t.off[(std::size_t)v + 1];
+        for (std::size_t u = 0; u < c.n; ++u) t.off[u + 1] += t.off[u];
+        t.nbr.resize(c.nbr.size());
+        std::pmr::vector<Off> cur(t.off.begin(), t.off.end() - 1, t.off.get_allocator());
+        for (std::size_t u = 0; u < c.n; ++u)
+            for (Id v : c.neighbors(u)) t.nbr[cur[(std::size_t)v]++] = (Id)u;
+        return t;
+    }
+}
+
+// Connected components of an undirected graph (BFS), strongly connected
+// ones of a directed graph (iterative Kosaraju: no recursion depth limit).
+template <bool D, typename Id, typename Off>
+std::size_t components(const Csr<D, Id, Off>& c){
+    std::vector<char> vis(c.n, 0);
+    std::vector<Id> queue;
+    std::size_t comps = 0;
+    auto flood = [&](const Csr<D, Id, Off>& g, Id s){   // BFS
+        vis[(std::size_t)s] = 1; queue.assign(1, s);
+        for (std::size_t head = 0; head < queue.size(); ++head)
+            for (Id v : g.neighbors((std::size_t)queue[head])) if (!vis[(std::size_t)v]) { vis[(std::size_t)v] = 1; queue.push_back(v); }
+    };
+    if constexpr (!D) {
+        for (std::size_t s = 0; s < c.n; ++s) if (!vis[s]) { ++comps; flood(c, (Id)s); }
+        return comps;
+    } else {
+        // pass 1: finishing order; the stack keeps each vertex's next slot
+        std::vector<Id> order; order.reserve(c.n);
+        std::vector<std::pair<Id, Off>> st;
+        for (std::size_t s = 0; s < c.n; ++s) {
+            if (vis[s]) continue;
+            vis[s] = 1; st.emplace_back((Id)s, c.off[s]);
+            while (!st.empty()) {
+                auto& [u, i] = st.back();
+                if (i == c.off[(std::size_t)u + 1]) { order.push_back(u); st.pop_back(); continue; }
+                Id v = c.nbr[i++];
+                if (!vis[(std::size_t)v]) { vis[(std::size_t)v] = 1; st.emplace_back(v, c.off[(std::size_t)v]); }
+            }
+        }
+        // pass 2: the transpose in decreasing finishing order
+        auto t = transpose(c);
+        std::fill(vis.begin(), vis.end(), 0);
+        for (auto r = order.rbegin(); r != order.rend(); ++r)
+            if (!vis[(std::size_t)*r]) { ++comps; flood(t, *r); }
+        return comps;
+    }
+}
+
+// The layout dispatch() picks: widths in bytes.
+struct Layout { bool directed; unsigned id_bytes, off_bytes; };
+
+inline Layout layout_of(std::size_t n, std::size_t arcs, bool directed){
+    unsigned id = n <= (std::size_t)std::numeric_limits<std::uint16_t>::max() + 1 ? 2
+                : n <= (std::size_t)std::numeric_limits<std::uint32_t>::max() + 1 ? 4 : 8;
+    unsigned off = id < 8 && arcs <= std::numeric_limits<std::uint32_t>::max() ? 4 : 8;
+    return {directed, id, off};
+}
+inline Layout layout_of(const Graph& g){
+    std::size_t arcs = 0;
+    for (auto& a : g.adj) arcs += a.size();
+    return layout_of(g.n, arcs, g.directed);
+}
+
+// e.g. "d/u16/u32"
+inline std::string layout_name(const Layout& l){
+    return std::string(l.directed ? "d" : "u") + "/u" + std::to_string(8 * l.id_bytes) + "/u" + std::to_string(8 * l.off_bytes);
+}
+
+template <bool D, typename Id, typename F>
+decltype(auto) dispatch_off(const Graph& g, const Layout& l, std::pmr::memory_resource* mr, F&& f){
+    if constexpr (sizeof(Id) < sizeof(std::uint64_t))
+        if (l.off_bytes == 4) return f(freeze<D, Id, std::uint32_t>(g, mr));
+    return f(freeze<D, Id, std::uint64_t>(g, mr));
+}
+
+template <bool D, typename F>
+decltype(auto) dispatch_id(const Graph& g, const Layout& l, std::pmr::memory_resource* mr, F&& f){
+    if (l.id_bytes == 2) return dispatch_off<D, std::uint16_t>(g, l, mr, f);
+    if (l.id_bytes == 4) return dispatch_off<D, std::uint32_t>(g, l, mr, f);
+    return dispatch_off<D, std::uint64_t>(g, l, mr, f);
+}
+
+// Calls f(csr) with g frozen into the narrowest layout, allocated from `mr`;
+// f must return the same type for every instantiation.
+template <typename F>
+decltype(auto) dispatch(const Graph& g, std::pmr::memory_resource* mr, F&& f){
+    Layout l = layout_of(g);
+    return l.directed ? dispatch_id<true>(g, l, mr, f) : dispatch_id<false>(g, l, mr, f);
+}
+template <typename F>
+decltype(auto) dispatch(const Graph& g, F&& f){ return dispatch(g, std::pmr::get_default_resource(), f); }
+
+} // namespace core
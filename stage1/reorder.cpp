@@ -0,0 +1,122 @@
+#include "reorder.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+namespace {
+    // undirected shape as one CSR: both directions of every arc
+    struct Sym {
+        std::vector<std::uint64_t> off;
+        std::vector<int> nbr;
+        std::size_t degree(int u) const { return (std::size_t)(off[(std::size_t)u + 1] - off[(std::size_t)u]); }
+    };
+
+    Sym symmetric(const Graph& g){
+        Sym s;
+        s.off.assign(g.n + 1, 0);
+        for (std::size_t u = 0; u < g.n; ++u) {
+            s.off[u + 1] += g.adj[u].size();
+            if (g.directed) for (int v : g.adj[u]) ++s.off[(std::size_t)v + 1];
+        }
+        std::partial_sum(s.off.begin(), s.off.end(), s.off.begin());
+        s.nbr.resize(s.off[g.n]);
+        std::vector<std::uint64_t> cur(s.off.begin(), s.off.end() - 1);
+        for (std::size_t u = 0; u < g.n; ++u)
+            for (int v : g.adj[u]) {
+                s.nbr[cur[u]++] = v;
+                if (g.directed) s.nbr[cur[(std::size_t)v]++] = (int)u;
+            }
+        return s;
+    }
+
+    // BFS over every component; `rcm` starts each one at its minimum-degree
+    // vertex and takes neighbours by increasing degree
+    std::vector<int> bfs_order(const Graph& g, bool rcm){
+        Sym s = symmetric(g);
+        std::vector<int> order; order.reserve(g.n);
+        std::vector<char> seen(g.n, 0);
+        std::vector<int> starts(g.n);
+        std::iota(starts.begin(), starts.end(), 0);
+        if (rcm) std::stable_sort(starts.begin(), starts.end(), [&](int a, int b){ return s.degree(a) < s.degree(b); });
+        std::vector<int> next;
+        for (int st : starts) {
+            if (seen[(std::size_t)st]) continue;
+            seen[(std::size_t)st] = 1;
+            std::size_t head = order.size();
+            order.push_back(st);
+            while (head < order.size()) {
+                int u = order[head++];
+                next.clear();
+                for (std::uint64_t i = s.off[(std::size_t)u]; i < s.off[(std::size_t)u + 1]; ++i) {
+                    int v = s.nbr[i];
+                    if (!seen[(std::size_t)v]) { seen[(std::size_t)v] = 1; next.push_back(v); }
+                }
+                if (rcm) std::sort(next.begin(), next.end(), [&](int a, int b){
+                    return s.degree(a) != s.degree(b) ? s.degree(a) < s.degree(b) : a < b; });
+                order.insert(order.end(), next.begin(), next.end());
+            }
+        }
+        if (rcm) std::reverse(order.begin(), order.end());
+        return order;
+    }
+}
+
+bool parse_reorder(const std::string& s, Reorder& out){
+    for (Reorder r : {Reorder::None, Reorder::Degree, Reorder::Bfs, Reorder::Rcm})
+        if (s == reorder_name(r)) { out = r; return true; }
+    return false;
+}
+
+const char* reorder_name(Reorder r){
+    switch (r) {
+        case Reorder::Degree: return "degree";
+        case Reorder::Bfs:    return "bfs";
+        case Reorder::Rcm:    return "rcm";
+        default:              return "none";
+    }
+}
+
+std::vector<int> vertex_order(const Graph& g, Reorder r){
+    std::vector<int> order(g.n);
+    std::iota(order.begin(), order.end(), 0);
+    switch (r) {
+        case Reorder::None: break;
+        case Reorder::Degree: {
+            std::vector<std::size_t> deg(g.n, 0);
+            for (std::size_t u = 0; u < g.n; ++u) {
+                deg[u] += g.adj[u].size();
+                if (g.directed) for (int v : g.adj[u]) ++deg[(std::size_t)v];
+            }
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b){ return deg[(std::size_t)a] > deg[(std::size_t)b]; });
+            break;
+        }
+        case Reorder::Bfs: order = bfs_order(g, false); break;
+        case Reorder::Rcm: order = bfs_order(g, true); break;
+    }
+    return order;
+}
+
+Graph permute(const Graph& g, const std::vector<int>& order){
+    std::vector<int> to_new(g.n);
+    for (std::size_t i = 0; i < g.n; ++i) to_new[(std::size_t)order[i]] = (int)i;
+    Graph p(g.n, g.directed);
+    for (std::size_t i = 0; i < g.n; ++i) {
+        const auto& src = g.adj[(std::size_t)order[i]];
+        auto& dst = p.adj[i];
+        dst.reserve(src.size());
+        for (int v : src) dst.push_back(to_new[(std::size_t)v]);
+        std::sort(dst.begin(), dst.end());
+    }
+    p.m = g.m;
+    return p;
+}
+
+std::shared_ptr<const Reordered> reorder_graph(const Graph& g, Reorder r){
+    std::vector<int> order = vertex_order(g, r);
+    Graph p = permute(g, order);
+    return std::make_shared<const Reordered>(Reordered{std::move(p), std::move(order)});
+}
+
+void to_original(std::vector<int>& ids, const std::vector<int>& to_old){
+    for (int& v : ids) v = to_old[(std::size_t)v];
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "graph.hpp"
+
+// Vertex reordering for locality. Random or uploaded ids scatter each
+// vertex's neighbours over the whole id range, so every step of a BFS/DFS
+// misses cache; renumbering vertices in traversal order keeps neighbours
+// close together.
+//
+//   degree  decreasing degree (hubs, touched most often, share cache lines)
+//   bfs     BFS order, component by component, from the lowest old id
+//   rcm     reverse Cuthill-McKee: BFS from a minimum-degree vertex,
+//           neighbours by increasing degree, whole order reversed
+//
+// Directed graphs are ordered on their undirected shape.
+enum class Reorder { None, Degree, Bfs, Rcm };
+
+bool parse_reorder(const std::string& s, Reorder& out);   // "none|degree|bfs|rcm"
+const char* reorder_name(Reorder r);
+
+// order[i] = old id of the vertex that becomes i
+std::vector<int> vertex_order(const Graph& g, Reorder r);
+
+// g renumbered by `order`, each list sorted
+Graph permute(const Graph& g, const std::vector<int>& order);
+
+// A permuted graph and, for every new id, the old one.
+struct Reordered {
+    Graph g;
+    std::vector<int> to_old;
+};
+std::shared_ptr<const Reordered> reorder_graph(const Graph& g, Reorder r);
+
+// Vertex ids written into results go through original_id(), so an algorithm
+// run on a permuted graph reports the caller's ids. Set for the current
+// thread with a LabelScope around the run. A graph imported with sparse ids
+// (edge_import.hpp: ImportStats::labels) adds a second table, applied after
+// the permutation.
+inline thread_local const std::vector<int>* current_labels = nullptr;
+inline thread_local const std::vector<long long>* current_file_ids = nullptr;
+inline long long original_id(int v){
+    long long u = current_labels ? (*current_labels)[(std::size_t)v] : v;
+    return current_file_ids ? (*current_file_ids)[(std::size_t)u] : u;
+}
+
+class LabelScope {
+public:
+    explicit LabelScope(const std::vector<int>* to_old, const std::vector<long long>* file_ids = nullptr)
+        : prev_(current_labels), prev_file_(current_file_ids) { current_labels = to_old; current_file_ids = file_ids; }
+    ~LabelScope(){ current_labels = prev_; current_file_ids = prev_file_; }
+    LabelScope(const LabelScope&) = delete;
+    LabelScope& operator=(const LabelScope&) = delete;
+private:
+    const std::vector<int>* prev_;
+    const std::vector<long long>* prev_file_;
+};
+
+// vertex sequences (circuits, paths) back to old ids, in place
+void to_original(std::vector<int>& ids, const std::vector<int>& to_old);
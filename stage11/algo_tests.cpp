@@ -1,8 +1,15 @@
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "graph.hpp"
 #include "algo.hpp"
+#include "derived.hpp"
+#include "reorder.hpp"
+#include "graph_cache.hpp"   // generate_Gnm
+#include "deadline.hpp"
 #include <memory>
 
 
@@ -14,8 +21,23 @@ static KV P(std::initializer_list<std::pair<std::string, std::string>> kv) {
     return m;
 }
 
+// a clique example may list its vertices in any order: sort them
+static std::string canon(const std::string& text) {
+    auto k = text.find("example:");
+    if (k == std::string::npos) return text;
+    std::istringstream in(text.substr(k + 8));
+    std::vector<long long> ids;
+    for (long long v; in >> v; ) ids.push_back(v);
+    std::sort(ids.begin(), ids.end());
+    std::string out = text.substr(0, k + 8);
+    for (long long v : ids) out += " " + std::to_string(v);
+    return out;
+}
+
 
 int main(){
+    int failures = 0;   // checks that compare answers; any failure fails the run
+
     // 1) SCC_COUNT: directed and undirected
     {
         Graph gd(5, true);
@@ -59,5 +81,101 @@ int main(){
         std::cout << r2.text << "\n";
     }
 
-    return 0;
+    // 4) BATCH path: every algorithm over one set of derived structures
+    {
+        auto g = std::make_shared<Graph>(5, true);
+        g->add_edge(0,1); g->add_edge(1,2); g->add_edge(2,0); g->add_edge(2,3); g->add_edge(3,4);
+        DerivedGraph d(g);
+        for (const char* name : {"SCC_COUNT", "HAM_CYCLE", "MAXCLIQUE", "NUM_MAXCLIQUES"}) {
+            std::unique_ptr<IAlgorithm> A(make_algorithm(name));
+            auto one = A->run(*g, P({{"timeout_ms","200"}}));
+            auto shared = run_with_derived(name, d, P({{"timeout_ms","200"}}));
+            bool same = shared.text == one.text;
+            failures += !same;
+            std::cout << name << " derived: " << shared.text << (same ? "" : "  [MISMATCH]") << "\n";
+        }
+    }
+
+    // 5) reorder=..: same answers on every relabelling, reported in original
+    // ids. On the second graph every ordering moves the K4 {0,3,6,8}, so its
+    // ids only come out right through LabelScope; the third is directed.
+    {
+        Graph a(6,false);
+        a.add_edge(1,2); a.add_edge(0,4); a.add_edge(1,4); a.add_edge(4,5); a.add_edge(1,5);
+        Graph b(9,false);
+        for (auto [u, v] : {std::pair{0,3}, {0,6}, {0,8}, {3,6}, {3,8}, {6,8}, {1,4}, {4,7}, {7,2}, {2,5}, {5,8}}) b.add_edge(u, v);
+        Graph c(9,true);
+        for (auto [u, v] : {std::pair{8,1}, {1,6}, {6,8}, {6,2}, {2,7}, {7,2}, {3,0}, {0,5}, {5,4}, {4,3}}) c.add_edge(u, v);
+        std::vector<const char*> und = {"SCC_COUNT", "MAXCLIQUE", "NUM_MAXCLIQUES"}, dir = {"SCC_COUNT"};
+        for (const Graph* g : {&a, &b, &c}) {
+            const auto& names = g->directed ? dir : und;
+            std::vector<std::string> want;
+            for (Reorder o : {Reorder::None, Reorder::Degree, Reorder::Bfs, Reorder::Rcm}) {
+                auto p = reorder_graph(*g, o);
+                std::vector<std::string> got, raw;
+                for (const char* name : names) {
+                    std::unique_ptr<IAlgorithm> A(make_algorithm(name));
+                    raw.push_back(canon(A->run(p->g, P({{"timeout_ms","200"}})).text));
+                    LabelScope ids(&p->to_old);
+                    got.push_back(canon(A->run(p->g, P({{"timeout_ms","200"}})).text));
+                }
+                if (o == Reorder::None) want = got;
+                bool same = got == want;
+                if (g == &b && o != Reorder::None) same = same && raw[1] != got[1];
+                failures += !same;
+                std::cout << reorder_name(o) << ":";
+                for (auto& t : got) std::cout << " [" << t << "]";
+                std::cout << (same ? "" : "  [MISMATCH]") << "\n";
+            }
+        }
+    }
+
+    // 6) Bron–Kerbosch counts on G(30,150), seeds 1..5 (checked by brute
+    // force), and again with 1070 isolated vertices added: each is one more
+    // maximal clique, and past 1024 vertices the search runs on vectors
+    {
+        const long long want[] = {101, 91, 97, 103, 93};
+        for (unsigned seed = 1; seed <= 5; ++seed) {
+            for (std::size_t pad : {0, 1070}) {
+                Graph g(30 + pad, false);
+                Graph small(30, false);
+                generate_Gnm(small, 150, seed);
+                for (std::size_t u = 0; u < 30; ++u) for (int v : small.adj[u]) g.add_edge((int)u, v);
+                std::unique_ptr<IAlgorithm> NM(make_algorithm("NUM_MAXCLIQUES"));
+                auto r = NM->run(g, P({{"timeout_ms","2000"}}));
+                bool same = r.text == "Maximal cliques count=" + std::to_string(want[seed-1] + (long long)pad);
+                failures += !same;
+                std::cout << "G(30,150) seed=" << seed << " +" << pad << ": " << r.text << (same ? "" : "  [MISMATCH]") << "\n";
+            }
+        }
+    }
+
+    // 7) deadlines: the budget passed on is rounded up, never below 1 ms and
+    // never ending before the deadline; a cheap algorithm with timeout_ms=1
+    // still answers
+    {
+        auto check = [&](const char* what, bool ok){ failures += !ok; if (!ok) std::cout << what << "  [MISMATCH]\n"; };
+        for (auto ahead : {std::chrono::microseconds(300), std::chrono::microseconds(1500), std::chrono::microseconds(250000)}) {
+            KV p = P({{"timeout_ms","9999"}});
+            auto d = DeadlineClock::now() + ahead;
+            bool live = apply_remaining(p, d);
+            long ms = std::atol(p["timeout_ms"].c_str());
+            check("apply_remaining rounds up", !live || (ms >= 1 && DeadlineClock::now() + std::chrono::milliseconds(ms) >= d));
+        }
+        KV past = P({{"timeout_ms","5"}});
+        check("apply_remaining past deadline", !apply_remaining(past, DeadlineClock::now() - std::chrono::microseconds(1)));
+
+        Graph g(5, true);
+        g.add_edge(0,1); g.add_edge(1,0); g.add_edge(2,3);
+        std::unique_ptr<IAlgorithm> A(make_algorithm("SCC_COUNT"));
+        KV p = P({{"timeout_ms","1"}});
+        bool live = apply_remaining(p, deadline_from(p, DeadlineClock::now()));
+        auto r = live ? A->run(g, p).text : std::string("ERR DEADLINE");
+        bool same = r == A->run(g, P({})).text;
+        failures += !same;
+        std::cout << "SCC_COUNT timeout_ms=1: " << r << (same ? "" : "  [MISMATCH]") << "\n";
+    }
+
+    if (failures) std::cout << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
 }
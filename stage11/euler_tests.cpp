@@ -1,20 +1,192 @@
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 #include "graph.hpp"
+#include "graph_core.hpp"
 #include "euler.hpp"
+#include "euler_check.hpp"
+
+// Reference answers by brute force, for the small graphs below.
+static std::size_t ref_weak(const Graph& g){
+    std::vector<std::size_t> p(g.n);
+    std::iota(p.begin(), p.end(), 0);
+    auto find = [&](std::size_t x){ while (p[x] != x) x = p[x] = p[p[x]]; return x; };
+    std::size_t comps = g.n;
+    for (std::size_t u = 0; u < g.n; ++u)
+        for (int v : g.adj[u]) if (auto a = find(u), b = find((std::size_t)v); a != b) { p[a] = b; --comps; }
+    return comps;
+}
+// u and v share a class iff each reaches the other
+static std::size_t ref_strong(const Graph& g){
+    std::vector<std::vector<char>> reach(g.n, std::vector<char>(g.n, 0));
+    for (std::size_t s = 0; s < g.n; ++s) {
+        std::vector<std::size_t> st{s}; reach[s][s] = 1;
+        while (!st.empty()) {
+            std::size_t u = st.back(); st.pop_back();
+            for (int v : g.adj[u]) if (!reach[s][(std::size_t)v]) { reach[s][(std::size_t)v] = 1; st.push_back((std::size_t)v); }
+        }
+    }
+    std::vector<char> done(g.n, 0);
+    std::size_t comps = 0;
+    for (std::size_t u = 0; u < g.n; ++u) {
+        if (done[u]) continue;
+        ++comps;
+        for (std::size_t v = u; v < g.n; ++v) if (reach[u][v] && reach[v][u]) done[v] = 1;
+    }
+    return comps;
+}
+
+// Eulerian iff every vertex has in == out (undirected: even degree) and the
+// vertices with edges are weakly connected (with in == out, that is strong
+// connectivity too)
+static bool ref_eulerian(const Graph& g){
+    auto in = g.in_degrees(), out = g.out_degrees();
+    std::vector<std::size_t> p(g.n);
+    std::iota(p.begin(), p.end(), 0);
+    auto find = [&](std::size_t x){ while (p[x] != x) x = p[x] = p[p[x]]; return x; };
+    for (std::size_t u = 0; u < g.n; ++u) {
+        if (g.directed ? in[u] != out[u] : out[u] % 2 != 0) return false;
+        for (int v : g.adj[u]) p[find(u)] = find((std::size_t)v);
+    }
+    std::size_t root = g.n;
+    for (std::size_t u = 0; u < g.n; ++u) if (in[u] + out[u] > 0) {
+        if (root == g.n) root = find(u);
+        else if (find(u) != root) return false;
+    }
+    return true;
+}
+// closed, and walks every edge exactly once
+static bool valid_circuit(const Graph& g, const std::vector<int>& c){
+    if (g.m == 0) return true;
+    if (c.size() != g.m + 1 || c.front() != c.back()) return false;
+    std::set<std::pair<int,int>> left;
+    for (std::size_t u = 0; u < g.n; ++u)
+        for (int v : g.adj[u]) if (g.directed || (int)u < v) left.emplace((int)u, v);
+    for (std::size_t i = 0; i + 1 < c.size(); ++i) {
+        std::pair<int,int> e(c[i], c[i+1]);
+        if (!g.directed && e.first > e.second) std::swap(e.first, e.second);
+        if (!left.erase(e)) return false;
+    }
+    return left.empty();
+}
 
 int main(){
+    int failures = 0;   // checks that compare answers; any failure fails the run
+
     // Euler: yes-case (cycle) & no-case (odd degree)
     {
         Graph g(4,false);
         g.add_edge(0,1); g.add_edge(1,2); g.add_edge(2,3); g.add_edge(3,0);
         auto r = euler_find(g);
         std::cout << (r.exists ? "EULER YES\n" : "EULER NO\n");
+        auto c = euler_check(CompressedGraph(g));
+        std::cout << (c.exists ? "EULER YES (compressed)\n" : "EULER NO (compressed) " + c.reason + "\n");
     }
     {
         Graph g(3,false);
         g.add_edge(0,1); g.add_edge(1,2); // degrees: 0->1, 1->2, 2->1 (two odd)
         auto r = euler_find(g);
         std::cout << (r.exists ? "EULER YES\n" : "EULER NO\n");
+        auto c = euler_check(CompressedGraph(g));
+        std::cout << (c.exists ? "EULER YES (compressed)\n" : "EULER NO (compressed) " + c.reason + "\n");
     }
-    return 0;
+
+    // CompressedGraph traversals and euler_check against the references and
+    // euler_find, on random sparse graphs of both directions
+    {
+        std::mt19937 rng(7);
+        int checked = 0, bad = 0;
+        for (int t = 0; t < 400; ++t) {
+            bool directed = t % 2;
+            std::size_t n = 1 + rng() % 40, m = rng() % (2 * n);
+            Graph g(n, directed);
+            for (std::size_t i = 0; i < m; ++i) g.add_edge((int)(rng() % n), (int)(rng() % n));
+            std::size_t weak = ref_weak(g), strong = directed ? ref_strong(g) : weak;
+            for (bool rev : {false, true}) {
+                CompressedGraph c(g, rev);
+                auto e = euler_find(g), ec = euler_check(c);
+                bool ok = weak_components(c) == weak && strong_components(c) == strong
+                       && ec.exists == e.exists && ec.reason == e.reason;
+                if (!ok && bad++ < 5)
+                    std::cout << "  mismatch: n=" << n << " m=" << g.m << " directed=" << directed << " reverse=" << rev
+                              << " weak " << weak_components(c) << "/" << weak << " strong " << strong_components(c) << "/" << strong
+                              << " euler " << ec.exists << "/" << e.exists << "\n";
+                ++checked;
+            }
+        }
+        failures += bad;
+        std::cout << "compressed components/euler_check: " << checked - bad << "/" << checked << " agree\n";
+    }
+
+    // core::components (dispatched as SCC_COUNT runs it) and euler_find
+    // against the references, on small random graphs and across the id-width
+    // boundary: u16 ids up to n = 65536, u32 from 65537
+    {
+        std::mt19937 rng(11);
+        int checked = 0, bad = 0;
+        auto check = [&](const std::string& what, bool ok){
+            ++checked;
+            if (!ok && bad++ < 5) std::cout << "  mismatch: " << what << "\n";
+        };
+        auto components = [](const Graph& g){ return core::dispatch(g, [](const auto& c){ return core::components(c); }); };
+
+        for (int t = 0; t < 400; ++t) {
+            bool directed = t % 2;
+            std::size_t n = 1 + rng() % 40, m = rng() % (2 * n);
+            Graph g(n, directed);
+            for (std::size_t i = 0; i < m; ++i) g.add_edge((int)(rng() % n), (int)(rng() % n));
+            auto e = euler_find(g);
+            check("random n=" + std::to_string(n) + " components",
+                  components(g) == (directed ? ref_strong(g) : ref_weak(g)));
+            check("random n=" + std::to_string(n) + " euler",
+                  e.exists == ref_eulerian(g) && (!e.exists || valid_circuit(g, e.circuit)));
+        }
+
+        for (std::size_t n : {1000, 65536, 65537}) for (bool directed : {false, true}) {
+            std::string tag = "n=" + std::to_string(n) + (directed ? "/d" : "/u");
+            std::vector<int> perm(n);
+            std::iota(perm.begin(), perm.end(), 0);
+            std::shuffle(perm.begin(), perm.end(), rng);
+
+            // blocks of 1..40 shuffled vertices, each a path (directed: a
+            // cycle), arcs only from earlier blocks to later ones: one
+            // component per block
+            Graph g(n, directed);
+            std::size_t blocks = 0;
+            for (std::size_t i = 0; i < n; ++blocks) {
+                std::size_t len = std::min<std::size_t>(n - i, 1 + rng() % 40);
+                for (std::size_t j = 0; j + 1 < len; ++j) g.add_edge(perm[i+j], perm[i+j+1]);
+                if (directed && len > 1) g.add_edge(perm[i+len-1], perm[i]);
+                if (directed && i > 0) for (int k = 0; k < 2; ++k) g.add_edge(perm[rng() % i], perm[i + rng() % len]);
+                i += len;
+            }
+            std::string layout = core::layout_name(core::layout_of(g)).substr(2, 3);
+            check(tag + " layout " + layout, layout == (n <= 65536 ? "u16" : "u32"));
+            check(tag + " components", components(g) == blocks);
+            if (!directed) {
+                Graph r(n, false);
+                for (std::size_t i = 0; i < n; ++i) r.add_edge((int)(rng() % n), (int)(rng() % n));
+                check(tag + " random components", components(r) == ref_weak(r));
+            }
+
+            // one cycle through every vertex is Eulerian; without one of its
+            // edges it is not
+            Graph h(n, directed);
+            for (std::size_t i = 0; i < n; ++i) h.add_edge(perm[i], perm[(i + 1) % n]);
+            auto e = euler_find(h);
+            check(tag + " euler cycle", e.exists && valid_circuit(h, e.circuit));
+            h.remove_edge(perm[n-1], perm[0]);
+            check(tag + " euler path", !euler_find(h).exists && !ref_eulerian(h));
+        }
+        failures += bad;
+        std::cout << "components/euler_find vs references: " << checked - bad << "/" << checked << " agree\n";
+    }
+
+    if (failures) std::cout << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
 }
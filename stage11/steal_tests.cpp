@@ -0,0 +1,61 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "steal_pool.hpp"
+
+// spin until pred() holds, false after 5 s
+template <typename F>
+static bool wait_for(F pred){
+    auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > until) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+int main(){
+    int failures = 0;   // checks that compare answers; any failure fails the run
+
+    // 1) tasks a worker submits land on its own deque; while it blocks on
+    // them, only the other worker can run them, by stealing
+    {
+        WorkStealingPool pool;
+        pool.start(2);
+        std::atomic<int> done{0}, on_owner{0};
+        std::atomic<bool> ok{false};
+        pool.submit([&]{
+            auto owner = std::this_thread::get_id();
+            for (int i = 0; i < 4; ++i)
+                pool.submit([&, owner]{ on_owner += std::this_thread::get_id() == owner; ++done; });
+            ok = wait_for([&]{ return done.load() == 4; });
+        });
+        bool finished = wait_for([&]{ return ok.load(); });
+        pool.stop();
+        bool same = finished && on_owner == 0 && pool.steals() == 4;
+        failures += !same;
+        std::cout << "local tasks: " << done << "/4 run, steals=" << pool.steals() << (same ? "" : "  [MISMATCH]") << "\n";
+    }
+
+    // 2) a backlog in the injection queue: the first worker to look takes
+    // t0 and t1 onto its deque, runs t0, which waits for t1, so t1 has to be
+    // stolen by the other worker
+    {
+        WorkStealingPool pool;
+        std::atomic<bool> t1_done{false}, ok{false};
+        std::atomic<int> done{0};
+        pool.submit([&]{ ok = wait_for([&]{ return t1_done.load(); }); ++done; });
+        pool.submit([&]{ t1_done = true; ++done; });
+        pool.submit([&]{ ++done; });
+        pool.start(2);   // submitted before start: all three are injected
+        bool finished = wait_for([&]{ return done.load() == 3; });
+        pool.stop();
+        bool same = finished && ok && pool.steals() >= 1;
+        failures += !same;
+        std::cout << "injected backlog: " << done << "/3 run, steals=" << pool.steals() << (same ? "" : "  [MISMATCH]") << "\n";
+    }
+
+    if (failures) std::cout << failures << " check(s) failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,374 @@
+// Microbenchmarks for the graph, Euler and algorithm kernels over fixed-seed
+// (n, m, directed) sweeps. Each case is warmed up, then timed in R samples;
+// a sample repeats the kernel until it has run for at least -t ms so that
+// fast kernels are not dominated by clock overhead. Reports ns/op as min,
+// median (with a 95% confidence interval), mean, stddev and max across
+// samples, as a table or JSON (-j).
+//
+// With -c <baseline.json> (a saved -j run) it compares instead: a case
+// regresses when its median is more than -x percent above the baseline's AND
+// the two confidence intervals do not overlap, so noise alone does not fail
+// it. A suspect case is measured again (up to -R more times, keeping its best
+// run) and only fails if the slowdown reproduces, which filters out drift on
+// a busy machine. Prints a diff table and exits 1 on any regression.
+//   bench_kernels [-r samples] [-w warmup samples] [-t min sample ms] [-n rounds] [-f filter] [-q] [-j]
+//                 [-c baseline.json [-x percent] [-R retries]]
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "graph.hpp"
+#include "euler.hpp"
+#include "algo.hpp"
+#include "graph_cache.hpp"   // generate_Gnm
+#include "arena.hpp"
+#include "reorder.hpp"
+#include "graph_core.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Case {
+    std::string name;                 // "kernel/n=../m=../d"
+    std::function<std::size_t()> op;  // one run; the result is folded into a sink
+};
+
+struct Summary { double min, median, mean, stddev, max, ci_lo, ci_hi; std::size_t iters; };
+
+static volatile std::size_t sink;    // keeps results observable
+
+static Summary measure(const Case& c, int samples, int warmup, double min_ms){
+    for (int i = 0; i < warmup; ++i) sink = sink + c.op();
+    // iterations per sample: enough to fill min_ms
+    std::size_t iters = 1;
+    while (true) {
+        auto t0 = Clock::now();
+        for (std::size_t i = 0; i < iters; ++i) sink = sink + c.op();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        if (ms >= min_ms || iters >= (1u << 24)) break;
+        iters = ms <= 0 ? iters * 16 : std::max(iters + 1, (std::size_t)((double)iters * min_ms * 1.2 / ms));
+    }
+    std::vector<double> ns;
+    for (int s = 0; s < samples; ++s) {
+        auto t0 = Clock::now();
+        for (std::size_t i = 0; i < iters; ++i) sink = sink + c.op();
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (double)iters);
+    }
+    std::sort(ns.begin(), ns.end());
+    Summary out{ns.front(), 0, 0, 0, ns.back(), ns.front(), ns.back(), iters};
+    std::size_t k = ns.size();
+    out.median = k % 2 ? ns[k/2] : (ns[k/2 - 1] + ns[k/2]) / 2;
+    // distribution-free 95% CI of the median: order statistics around k/2
+    // (normal approximation to Binomial(k, 1/2)); the full range for small k
+    double half = 0.98 * std::sqrt((double)k);
+    long lo = (long)std::floor((double)k / 2 - half), hi = (long)std::ceil((double)k / 2 + half);
+    if (lo >= 0 && hi < (long)k) { out.ci_lo = ns[(std::size_t)lo]; out.ci_hi = ns[(std::size_t)hi]; }
+    for (double v : ns) out.mean += v;
+    out.mean /= (double)k;
+    for (double v : ns) out.stddev += (v - out.mean) * (v - out.mean);
+    out.stddev = k > 1 ? std::sqrt(out.stddev / (double)(k - 1)) : 0;
+    return out;
+}
+
+// -n rounds: the median round (by median), with the CI widened to cover every
+// round, so a recorded baseline carries the run-to-run drift as well
+static Summary measure_rounds(const Case& c, int rounds, int samples, int warmup, double min_ms){
+    std::vector<Summary> rs;
+    for (int r = 0; r < rounds; ++r) rs.push_back(measure(c, samples, warmup, min_ms));
+    std::sort(rs.begin(), rs.end(), [](auto& a, auto& b){ return a.median < b.median; });
+    Summary out = rs[rs.size() / 2];
+    for (auto& r : rs) {
+        out.min = std::min(out.min, r.min); out.max = std::max(out.max, r.max);
+        out.ci_lo = std::min(out.ci_lo, r.ci_lo); out.ci_hi = std::max(out.ci_hi, r.ci_hi);
+    }
+    return out;
+}
+
+static std::string tag(std::size_t n, std::size_t m, bool directed){
+    return "/n=" + std::to_string(n) + "/m=" + std::to_string(m) + (directed ? "/d" : "/u");
+}
+
+static std::shared_ptr<Graph> gnm(std::size_t n, std::size_t m, bool directed, unsigned seed){
+    auto g = std::make_shared<Graph>(n, directed);
+    generate_Gnm(*g, m, seed);
+    return g;
+}
+
+// connected graph where every vertex has even degree (undirected) or
+// in == out (directed): i -- i+s (mod n) for s = 1..k
+static std::shared_ptr<Graph> circulant(std::size_t n, std::size_t k, bool directed){
+    auto g = std::make_shared<Graph>(n, directed);
+    for (std::size_t s = 1; s <= k; ++s)
+        for (std::size_t i = 0; i < n; ++i) g->add_edge((int)i, (int)((i + s) % n));
+    return g;
+}
+
+static std::vector<Case> build_cases(bool quick){
+    std::vector<Case> cs;
+    const unsigned seed = 42;
+    const std::size_t big = quick ? 20000 : 200000;
+
+    // bulk load: a fixed random edge list into a fresh Graph (duplicates included)
+    for (bool d : {false, true})
+        for (std::size_t avg : {4, 16}) {
+            std::size_t n = big, m = n * avg / 2;
+            auto edges = std::make_shared<std::vector<std::pair<int,int>>>();
+            std::mt19937 rng(seed);
+            std::uniform_int_distribution<int> v(0, (int)n - 1);
+            for (std::size_t i = 0; i < m; ++i) edges->push_back({v(rng), v(rng)});
+            cs.push_back({"add_edge" + tag(n, m, d), [=]{
+                Graph g(n, d);
+                for (auto [a, b] : *edges) g.add_edge(a, b);
+                return g.m;
+            }});
+        }
+
+    // G(n,m) generation, sparse to dense
+    for (bool d : {false, true})
+        for (std::size_t avg : {2, 8, 32}) {
+            std::size_t n = quick ? 2000 : 10000, m = n * avg / 2;
+            cs.push_back({"generate_Gnm" + tag(n, m, d), [=]{ Graph g(n, d); generate_Gnm(g, m, seed); return g.m; }});
+        }
+
+    // Euler circuit on connected Eulerian graphs
+    for (bool d : {false, true})
+        for (std::size_t k : {2, 8}) {
+            std::size_t n = big;
+            auto g = circulant(n, k, d);
+            cs.push_back({"euler_find" + tag(n, g->m, d), [=]{ return euler_find(*g).circuit.size(); }});
+        }
+
+    // algorithms: SCC over large sparse graphs, the NP-hard ones on sizes
+    // that finish well within their budget
+    struct AlgSweep { const char* alg; bool directed; std::vector<std::pair<std::size_t,std::size_t>> nm; KV params; };
+    const std::vector<AlgSweep> sweeps = {
+        {"SCC_COUNT", true,  {{big / 10, big / 10}, {big / 10, big / 5}, {big, 2 * big}}, {}},
+        {"SCC_COUNT", false, {{big / 10, big / 10}, {big, 2 * big}}, {}},
+        {"HAM_CYCLE", false, {{12, 30}, {16, 60}, {20, 120}}, {{"limit", "64"}}},
+        {"HAM_CYCLE", true,  {{12, 60}, {16, 120}}, {{"limit", "64"}}},
+        {"MAXCLIQUE", false, {{30, 150}, {60, 600}, {100, 1500}}, {}},
+        {"NUM_MAXCLIQUES", false, {{30, 150}, {60, 600}, {100, 1500}}, {}},
+    };
+    for (auto& s : sweeps)
+        for (auto [n, m] : s.nm) {
+            auto g = gnm(n, m, s.directed, seed);
+            std::shared_ptr<IAlgorithm> A(make_algorithm(s.alg));
+            KV params = s.params;
+            cs.push_back({std::string(s.alg) + tag(n, m, s.directed), [=]{ return A->run(*g, params).text.size(); }});
+        }
+
+    // Kosaraju on one pre-frozen graph at each id width (graph_core.hpp):
+    // what narrower ids save in bandwidth alone
+    {
+        std::size_t n = quick ? 20000 : 60000, m = 4 * n;
+        auto g = gnm(n, m, true, seed);
+        auto c16 = std::make_shared<core::Csr<true, std::uint16_t, std::uint32_t>>(core::freeze<true, std::uint16_t, std::uint32_t>(*g));
+        auto c32 = std::make_shared<core::Csr<true, std::uint32_t, std::uint32_t>>(core::freeze<true, std::uint32_t, std::uint32_t>(*g));
+        auto c64 = std::make_shared<core::Csr<true, std::uint64_t, std::uint64_t>>(core::freeze<true, std::uint64_t, std::uint64_t>(*g));
+        cs.push_back({"scc_core/u16" + tag(n, m, true), [=]{ return core::components(*c16); }});
+        cs.push_back({"scc_core/u32" + tag(n, m, true), [=]{ return core::components(*c32); }});
+        cs.push_back({"scc_core/u64" + tag(n, m, true), [=]{ return core::components(*c64); }});
+    }
+
+    // the same SCC run after reorder=.. relabelling (the permutation itself
+    // is paid once per cached graph, so it is not timed)
+    {
+        std::size_t n = big, m = 2 * big;
+        auto g = gnm(n, m, true, seed);
+        std::shared_ptr<IAlgorithm> A(make_algorithm("SCC_COUNT"));
+        for (Reorder r : {Reorder::None, Reorder::Degree, Reorder::Bfs, Reorder::Rcm}) {
+            std::shared_ptr<const Reordered> p = reorder_graph(*g, r);
+            cs.push_back({std::string("SCC_COUNT_reorder_") + reorder_name(r) + tag(n, m, true),
+                          [=]{ return A->run(p->g, {}).text.size(); }});
+        }
+    }
+
+    // what a GRAPH request allocates: build its graph, run SCC and both
+    // clique searches, drop it all; 8 requests split over 1 or 4 threads,
+    // with the scratch pools against plain malloc (server -A)
+    {
+        std::size_t n = quick ? 500 : 2000, m = 4 * n;
+        auto edges = std::make_shared<std::vector<std::pair<int,int>>>();
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> v(0, (int)n - 1);
+        for (std::size_t i = 0; i < m; ++i) edges->push_back({v(rng), v(rng)});
+        for (bool on : {true, false})
+            for (int threads : {1, 4})
+                cs.push_back({std::string("request_") + (on ? "arena" : "malloc") + "_t" + std::to_string(threads) + tag(n, m, true), [=]{
+                    arena::enable(on);
+                    std::vector<std::size_t> out((std::size_t)threads, 0);
+                    auto worker = [&](int t){
+                        for (int r = 0; r < 8 / threads; ++r) {
+                            auto g = std::make_shared<Graph>(n, true);
+                            for (auto [a, c] : *edges) g->add_edge(a, c);
+                            for (const char* alg : {"SCC_COUNT", "MAXCLIQUE", "NUM_MAXCLIQUES"})
+                                out[(std::size_t)t] += std::unique_ptr<IAlgorithm>(make_algorithm(alg))->run(*g, {}).text.size();
+                            arena::trim_scratch();
+                        }
+                    };
+                    std::vector<std::thread> ts;
+                    for (int t = 1; t < threads; ++t) ts.emplace_back(worker, t);
+                    worker(0);
+                    for (auto& t : ts) t.join();
+                    arena::enable(true);
+                    std::size_t sum = 0;
+                    for (auto x : out) sum += x;
+                    return sum;
+                }});
+    }
+    return cs;
+}
+
+// name -> {median, ci_lo, ci_hi} from a saved -j run
+struct Baseline { double median, ci_lo, ci_hi; };
+static bool load_baseline(const std::string& path, std::vector<std::pair<std::string, Baseline>>& out){
+    std::ifstream in(path);
+    if (!in) return false;
+    std::stringstream ss; ss << in.rdbuf();
+    std::string j = ss.str();
+    // position just past `"key":` (and any blanks) in [from, to), npos if absent
+    auto value = [&](const char* key, std::size_t from, std::size_t to){
+        std::size_t p = j.find(std::string("\"") + key + "\"", from);
+        if (p >= to) return std::string::npos;
+        p = j.find(':', p);
+        if (p >= to) return std::string::npos;
+        return j.find_first_not_of(" \t\r\n", p + 1);
+    };
+    auto number = [&](const char* key, std::size_t from, std::size_t to){
+        std::size_t p = value(key, from, to);
+        return p < to ? std::atof(j.c_str() + p) : -1.0;
+    };
+    for (std::size_t p = j.find("\"name\""); p != std::string::npos; p = j.find("\"name\"", p + 1)) {
+        std::size_t end = j.find('}', p), b = value("name", p, end);
+        if (b >= end || j[b] != '"') return false;
+        std::size_t e = j.find('"', b + 1);
+        Baseline r{number("median_ns", p, end), number("ci_lo_ns", p, end), number("ci_hi_ns", p, end)};
+        if (e >= end || r.median <= 0) return false;
+        if (r.ci_lo < 0 || r.ci_hi < 0) r.ci_lo = r.ci_hi = r.median;
+        out.push_back({j.substr(b + 1, e - b - 1), r});
+    }
+    return !out.empty();
+}
+
+// diff table against the baseline; true when nothing regressed
+static bool compare(std::vector<std::pair<std::string, Summary>>& now,
+                    const std::vector<std::pair<std::string, Baseline>>& base, double pct,
+                    int retries, const std::function<Summary(const std::string&)>& remeasure){
+    auto slower = [&](const Summary& s, const Baseline& b){
+        return 100.0 * (s.median - b.median) / b.median > pct && s.ci_lo > b.ci_hi;
+    };
+    char buf[256];
+    std::snprintf(buf, sizeof buf, "%-44s %12s %12s %8s  %s\n", "case", "base_ns", "now_ns", "change", "verdict");
+    std::cout << buf;
+    int regressed = 0, compared = 0;
+    for (auto& [name, s] : now) {
+        auto it = std::find_if(base.begin(), base.end(), [&](auto& b){ return b.first == name; });
+        if (it == base.end()) {
+            std::snprintf(buf, sizeof buf, "%-44s %12s %12.0f %8s  new\n", name.c_str(), "-", s.median, "");
+            std::cout << buf;
+            continue;
+        }
+        const Baseline& b = it->second;
+        for (int r = 0; r < retries && slower(s, b); ++r) {
+            Summary again = remeasure(name);
+            if (again.median < s.median) s = again;
+        }
+        double change = 100.0 * (s.median - b.median) / b.median;
+        const char* verdict = "ok";
+        if (slower(s, b))                            { verdict = "SLOWER"; ++regressed; }
+        else if (change < -pct && s.ci_hi < b.ci_lo) verdict = "faster";
+        else if (std::fabs(change) > pct)            verdict = "ok (within noise)";
+        std::snprintf(buf, sizeof buf, "%-44s %12.0f %12.0f %+7.1f%%  %s\n", name.c_str(), b.median, s.median, change, verdict);
+        std::cout << buf;
+        ++compared;
+    }
+    std::cout << compared << " cases compared, " << regressed << " regressed (threshold " << pct << "%)\n";
+    return regressed == 0;
+}
+
+static void usage(const char* p){
+    std::cerr << "Usage: " << p << " [-r <samples>] [-w <warmup>] [-t <min sample ms>] [-n <rounds>] [-f <name filter>] [-q] [-j]\n"
+              << "          [-c <baseline.json> [-x <percent>]]\n"
+              << "  -n  measure each case in this many rounds and keep the middle one (default: 1)\n"
+              << "  -q  smaller sweeps (quick check)\n"
+              << "  -j  one JSON object: {\"cases\":[{\"name\":..,\"median_ns\":..},...]}\n"
+              << "  -c  compare with a saved -j run; exit 1 if a case is slower beyond noise\n"
+              << "  -x  regression threshold on the median, percent (default: 10)\n"
+              << "  -R  re-measure a suspect case up to this many times before failing it (default: 2)\n";
+}
+
+int main(int argc, char** argv){
+    int samples = 10, warmup = 2, retries = 2, rounds = 1;
+    double min_ms = 20, pct = 10;
+    bool quick = false, json = false;
+    std::string filter, baseline_path;
+    for (int i=1; i<argc; ++i){
+        std::string a = argv[i];
+        if (a=="-r" && i+1<argc) samples = std::max(1, std::atoi(argv[++i]));
+        else if (a=="-w" && i+1<argc) warmup = std::max(0, std::atoi(argv[++i]));
+        else if (a=="-t" && i+1<argc) min_ms = std::max(0.1, std::atof(argv[++i]));
+        else if (a=="-f" && i+1<argc) filter = argv[++i];
+        else if (a=="-n" && i+1<argc) rounds = std::max(1, std::atoi(argv[++i]));
+        else if (a=="-q") quick = true;
+        else if (a=="-j") json = true;
+        else if (a=="-c" && i+1<argc) baseline_path = argv[++i];
+        else if (a=="-x" && i+1<argc) pct = std::atof(argv[++i]);
+        else if (a=="-R" && i+1<argc) retries = std::max(0, std::atoi(argv[++i]));
+        else { usage(argv[0]); return 2; }
+    }
+
+    std::vector<std::pair<std::string, Baseline>> base;
+    if (!baseline_path.empty()) {
+        if (!load_baseline(baseline_path, base)) { std::cerr << "cannot read baseline " << baseline_path << "\n"; return 2; }
+        json = false;
+    }
+
+    std::vector<std::pair<std::string, Summary>> results;
+    bool first = true;
+    if (!base.empty()) std::cerr << "measuring...\n";
+    else if (json) std::cout << "{\"samples\":" << samples << ",\"warmup\":" << warmup << ",\"cases\":[";
+    else {
+        char h[160];
+        std::snprintf(h, sizeof h, "%-44s %12s %12s %12s %8s %8s\n", "case", "median_ns", "min_ns", "max_ns", "cv%", "iters");
+        std::cout << h;
+    }
+    auto cases = build_cases(quick);
+    for (auto& c : cases) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+        auto s = measure_rounds(c, rounds, samples, warmup, min_ms);
+        results.push_back({c.name, s});
+        if (!base.empty()) continue;
+        char buf[400];
+        if (json) {
+            std::snprintf(buf, sizeof buf,
+                "%s{\"name\":\"%s\",\"iters\":%zu,\"min_ns\":%.1f,\"median_ns\":%.1f,\"ci_lo_ns\":%.1f,\"ci_hi_ns\":%.1f,"
+                "\"mean_ns\":%.1f,\"stddev_ns\":%.1f,\"max_ns\":%.1f}",
+                first ? "" : ",", c.name.c_str(), s.iters, s.min, s.median, s.ci_lo, s.ci_hi, s.mean, s.stddev, s.max);
+        } else {
+            std::snprintf(buf, sizeof buf, "%-44s %12.0f %12.0f %12.0f %8.2f %8zu\n",
+                          c.name.c_str(), s.median, s.min, s.max, s.mean > 0 ? 100 * s.stddev / s.mean : 0.0, s.iters);
+        }
+        std::cout << buf << std::flush;
+        first = false;
+    }
+    if (!base.empty()) {
+        auto remeasure = [&](const std::string& name){
+            auto& c = *std::find_if(cases.begin(), cases.end(), [&](auto& x){ return x.name == name; });
+            return measure(c, samples, warmup, min_ms);
+        };
+        return compare(results, base, pct, retries, remeasure) ? 0 : 1;
+    }
+    if (json) std::cout << "]}\n";
+    return 0;
+}
@@ -0,0 +1,260 @@
+// Load generator for server8 / server9. Each request is one connection (the
+// servers close after replying); the whole reply is read until EOF.
+//
+//  closed loop (-r 0): every one of -c connections sends its next request as
+//    soon as the previous reply is in, so throughput is what the server
+//    sustains at that concurrency.
+//  open loop (-r R):   requests are due at a fixed R/s schedule, whatever the
+//    server does; latency is measured from the time a request was due, not
+//    from when a connection got round to sending it, so a stalled server is
+//    charged for the requests it delayed (no coordinated omission). -c bounds
+//    the requests in flight.
+//
+// The mix file has one "<weight> <request>" per line ('#' comments); "\n" in
+// a request becomes a newline (GRAPH bodies) and "{i}" the request's sequence
+// number (e.g. seed={i} to defeat the result cache).
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+#include "metrics.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct MixEntry {
+    double weight;
+    std::string text;    // request with "\n" already expanded
+    std::string label;   // algorithm name (or first word) for the report
+};
+
+struct Class {
+    std::string label;
+    LatencyHistogram lat;
+    std::atomic<std::uint64_t> ok{0}, err{0}, bytes{0};
+};
+
+static std::vector<MixEntry> default_mix(){
+    // the stage10/stage11 workload.sh mix
+    return {
+        {1, "ALG SCC_COUNT RANDOM n=200 m=800 seed={i} directed=1", "SCC_COUNT"},
+        {1, "ALG HAM_CYCLE RANDOM n=16 m=24 seed={i} directed=0 limit=16 timeout_ms=250", "HAM_CYCLE"},
+        {1, "ALG MAXCLIQUE RANDOM n=22 m=40 seed={i} directed=0 timeout_ms=200", "MAXCLIQUE"},
+        {1, "ALG NUM_MAXCLIQUES RANDOM n=22 m=40 seed={i} directed=0 timeout_ms=200", "NUM_MAXCLIQUES"},
+    };
+}
+
+static bool load_mix(const std::string& path, std::vector<MixEntry>& out){
+    std::ifstream in(path);
+    if (!in) { std::cerr << "cannot open " << path << "\n"; return false; }
+    std::string line;
+    int ln = 0;
+    while (std::getline(in, line)) {
+        ++ln;
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        double w; std::string rest;
+        if (!(ss >> w) || w <= 0 || !std::getline(ss >> std::ws, rest) || rest.empty()) {
+            std::cerr << path << ":" << ln << ": expected '<weight> <request>'\n";
+            return false;
+        }
+        std::string text;
+        for (std::size_t i = 0; i < rest.size(); ++i) {
+            if (rest[i] == '\\' && i + 1 < rest.size() && rest[i+1] == 'n') { text += '\n'; ++i; }
+            else text += rest[i];
+        }
+        std::istringstream ts(text);
+        std::string w1, w2;
+        ts >> w1 >> w2;
+        out.push_back({w, text, (w1 == "ALG" || w1 == "RUN") && !w2.empty() ? w2 : w1});
+    }
+    if (out.empty()) { std::cerr << path << ": no requests\n"; return false; }
+    return true;
+}
+
+static std::string expand(const std::string& t, std::uint64_t i){
+    std::string out;
+    for (std::size_t p = 0; p < t.size(); ) {
+        if (t.compare(p, 3, "{i}") == 0) { out += std::to_string(i); p += 3; }
+        else out += t[p++];
+    }
+    return out;
+}
+
+// one request on a fresh connection; the reply (until EOF) in `reply`
+static bool roundtrip(const sockaddr_in& addr, const std::string& req, std::string& reply){
+    reply.clear();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1; setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    if (connect(fd, (const sockaddr*)&addr, sizeof addr) < 0) { close(fd); return false; }
+    std::string line = req + "\n";
+    for (std::size_t off = 0; off < line.size(); ) {
+        ssize_t w = send(fd, line.data() + off, line.size() - off, MSG_NOSIGNAL);
+        if (w <= 0) { close(fd); return false; }
+        off += (std::size_t)w;
+    }
+    shutdown(fd, SHUT_WR);
+    char buf[16384];
+    while (true) {
+        ssize_t r = recv(fd, buf, sizeof buf, 0);
+        if (r < 0) { close(fd); return false; }
+        if (r == 0) break;
+        reply.append(buf, (std::size_t)r);
+    }
+    close(fd);
+    return !reply.empty();
+}
+
+static void usage(const char* p){
+    std::cerr << "Usage: " << p << " -p <port> [-c <connections>] [-d <seconds>] [-r <req/s>] [-f <mix file>]\n"
+              << "          [-w <warmup seconds>] [-s <seed>] [-j | -1]\n"
+              << "  -c  concurrent connections (closed loop) / max in flight (open loop) (default: 8)\n"
+              << "  -d  measured duration in seconds (default: 10)\n"
+              << "  -r  open loop at this many requests/s; 0 = closed loop (default: 0)\n"
+              << "  -f  request mix, lines of '<weight> <request>' (default: the workload.sh mix)\n"
+              << "  -w  warmup before measuring, seconds (default: 1)\n"
+              << "  -j  print the report as one JSON object\n"
+              << "  -1  print only the totals as one 'rps=.. p50_us=.. ...' line (for scripts)\n";
+}
+
+int main(int argc, char** argv){
+    int port = 0, conns = 8;
+    double duration = 10, rate = 0, warmup = 1;
+    unsigned seed = 1;
+    bool json = false, oneline = false;
+    std::string mix_path;
+    for (int i=1; i<argc; ++i){
+        std::string a = argv[i];
+        if (a=="-p" && i+1<argc) port = std::atoi(argv[++i]);
+        else if (a=="-c" && i+1<argc) conns = std::max(1, std::atoi(argv[++i]));
+        else if (a=="-d" && i+1<argc) duration = std::atof(argv[++i]);
+        else if (a=="-r" && i+1<argc) rate = std::atof(argv[++i]);
+        else if (a=="-f" && i+1<argc) mix_path = argv[++i];
+        else if (a=="-w" && i+1<argc) warmup = std::max(0.0, std::atof(argv[++i]));
+        else if (a=="-s" && i+1<argc) seed = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+        else if (a=="-j") json = true;
+        else if (a=="-1") oneline = true;
+        else { usage(argv[0]); return 2; }
+    }
+    if (port <= 0 || duration <= 0) { usage(argv[0]); return 2; }
+
+    std::vector<MixEntry> mix;
+    if (mix_path.empty()) mix = default_mix();
+    else if (!load_mix(mix_path, mix)) return 2;
+
+    // one report row per label, plus the total
+    std::vector<std::unique_ptr<Class>> classes;
+    std::vector<Class*> class_of(mix.size());
+    for (std::size_t k = 0; k < mix.size(); ++k) {
+        auto it = std::find_if(classes.begin(), classes.end(), [&](auto& c){ return c->label == mix[k].label; });
+        if (it == classes.end()) { classes.push_back(std::make_unique<Class>()); classes.back()->label = mix[k].label; it = classes.end() - 1; }
+        class_of[k] = it->get();
+    }
+    Class total; total.label = "ALL";
+    std::vector<double> weights;
+    for (auto& m : mix) weights.push_back(m.weight);
+
+    sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    const auto start = Clock::now() + std::chrono::milliseconds(10);
+    const auto measure_from = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(warmup));
+    const auto stop_at = measure_from + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+    const auto period = rate > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))
+                                 : Clock::duration::zero();
+    std::atomic<std::uint64_t> next{0}, late{0};
+
+    auto worker = [&](int id){
+        std::mt19937_64 rng(seed * 1000003ULL + (unsigned)id);
+        std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+        std::string reply;
+        while (true) {
+            std::uint64_t i = next.fetch_add(1, std::memory_order_relaxed);
+            Clock::time_point due;
+            if (rate > 0) {
+                due = start + period * (long long)i;
+                if (due >= stop_at) break;
+                auto now = Clock::now();
+                if (due > now) std::this_thread::sleep_until(due);
+                else if (now - due > std::chrono::milliseconds(1)) late.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                due = Clock::now();
+                if (due >= stop_at) break;
+            }
+            std::size_t k = pick(rng);
+            bool ok = roundtrip(addr, expand(mix[k].text, i), reply) && reply.rfind("OK", 0) == 0;
+            auto done = Clock::now();
+            if (due < measure_from) continue;
+            for (Class* c : {class_of[k], &total}) {
+                c->lat.record(done - due);
+                (ok ? c->ok : c->err).fetch_add(1, std::memory_order_relaxed);
+                c->bytes.fetch_add(reply.size(), std::memory_order_relaxed);
+            }
+        }
+    };
+    std::vector<std::thread> ts;
+    for (int c = 0; c < conns; ++c) ts.emplace_back(worker, c);
+    for (auto& t : ts) t.join();
+    double secs = std::chrono::duration<double>(std::max(Clock::now(), stop_at) - measure_from).count();
+
+    std::vector<Class*> rows;
+    for (auto& c : classes) rows.push_back(c.get());
+    rows.push_back(&total);
+    auto row_json = [&](Class& c){
+        auto s = c.lat.snapshot();
+        char buf[512];
+        std::snprintf(buf, sizeof buf,
+            "{\"ok\":%llu,\"err\":%llu,\"rps\":%.1f,\"bytes\":%llu,\"mean_us\":%llu,\"p50_us\":%llu,\"p90_us\":%llu,"
+            "\"p99_us\":%llu,\"p999_us\":%llu,\"max_us\":%llu}",
+            (unsigned long long)c.ok.load(), (unsigned long long)c.err.load(), (double)s.count / secs,
+            (unsigned long long)c.bytes.load(), (unsigned long long)(s.count ? s.sum_us / s.count : 0),
+            (unsigned long long)s.p50, (unsigned long long)s.p90, (unsigned long long)s.p99,
+            (unsigned long long)s.p999, (unsigned long long)s.max_us);
+        return std::string(buf);
+    };
+    if (oneline) {
+        auto s = total.lat.snapshot();
+        std::cout << "rps=" << (double)s.count / secs << " ok=" << total.ok.load() << " err=" << total.err.load()
+                  << " p50_us=" << s.p50 << " p99_us=" << s.p99 << " p999_us=" << s.p999 << " max_us=" << s.max_us
+                  << " late=" << late.load() << "\n";
+    } else if (json) {
+        std::cout << "{\"mode\":\"" << (rate > 0 ? "open" : "closed") << "\",\"connections\":" << conns
+                  << ",\"rate\":" << rate << ",\"seconds\":" << secs << ",\"late\":" << late.load() << ",\"classes\":{";
+        for (std::size_t k = 0; k < rows.size(); ++k)
+            std::cout << (k ? "," : "") << "\"" << rows[k]->label << "\":" << row_json(*rows[k]);
+        std::cout << "}}\n";
+    } else {
+        std::cout << (rate > 0 ? "open loop " + std::to_string((long long)rate) + " req/s" : std::string("closed loop"))
+                  << ", " << conns << " connections, " << secs << "s measured";
+        if (late.load()) std::cout << ", " << late.load() << " requests sent >1ms late (raise -c)";
+        std::cout << "\n";
+        char buf[256];
+        std::snprintf(buf, sizeof buf, "  %-15s %8s %6s %9s %9s %9s %9s %9s %9s\n",
+                      "class", "ok", "err", "req/s", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+        std::cout << buf;
+        for (Class* c : rows) {
+            auto s = c->lat.snapshot();
+            std::snprintf(buf, sizeof buf, "  %-15s %8llu %6llu %9.1f %9llu %9llu %9llu %9llu %9llu\n",
+                          c->label.c_str(), (unsigned long long)c->ok.load(), (unsigned long long)c->err.load(),
+                          (double)s.count / secs, (unsigned long long)s.p50, (unsigned long long)s.p90,
+                          (unsigned long long)s.p99, (unsigned long long)s.p999, (unsigned long long)s.max_us);
+            std::cout << buf;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+# Thread scaling of server8 (leader/follower) vs server9 (active-object
+# pipeline). For every server x thread count x request mix it starts the
+# server, drives it with loadgen (closed loop, CONNS connections) and records
+# throughput, p50/p99/p999 latency and the server's CPU use in cores
+# (utime+stime from /proc over the run). Mixes: mix_cheap.txt (SCC only),
+# mix.txt (the workload.sh set) and mix_heavy.txt (NP-hard-heavy).
+# Prints a table and writes scale_results.csv (one row per configuration,
+# ready to plot rps or p99 against threads).
+#   usage: scale_bench.sh [threads list] [seconds] [connections]
+#   e.g.   scale_bench.sh "1 2 4 8" 5 32
+set -euo pipefail
+THREADS_LIST="${1:-1 2 4 8}"
+SECS="${2:-5}"
+CONNS="${3:-32}"
+HERE="$(cd "$(dirname "$0")" && pwd)"
+LOADGEN="$HERE/loadgen"
+SERVER8="$HERE/../stage8/server8"
+SERVER9="$HERE/../stage9/server9"
+OUT="$HERE/scale_results.csv"
+PORT=5631
+TCK=$(getconf CLK_TCK)
+
+cpu_ticks(){ awk '{ print $14 + $15 }' "/proc/$1/stat"; }
+
+run(){
+    local server="$1" threads="$2" mix="$3" bin
+    bin=$([ "$server" = server8 ] && echo "$SERVER8" || echo "$SERVER9")
+    "$bin" -p "$PORT" -t "$threads" >/dev/null 2>&1 &
+    local srv=$!
+    sleep 0.4
+    local c0 t0 line c1 t1
+    c0=$(cpu_ticks "$srv"); t0=$(date +%s%N)
+    line=$("$LOADGEN" -p "$PORT" -c "$CONNS" -d "$SECS" -w 1 -f "$HERE/$mix" -1)
+    c1=$(cpu_ticks "$srv"); t1=$(date +%s%N)
+    kill -INT "$srv" 2>/dev/null || true
+    wait "$srv" 2>/dev/null || true
+    PORT=$((PORT+1))
+    local cores
+    cores=$(awk -v c=$((c1 - c0)) -v t=$((t1 - t0)) -v hz="$TCK" 'BEGIN { printf "%.2f", (c / hz) / (t / 1e9) }')
+    # "rps=.. ok=.. err=.. p50_us=.. p99_us=.. p999_us=.. max_us=.. late=.."
+    echo "$line" | awk -v s="$server" -v th="$threads" -v m="${mix%.txt}" -v cpu="$cores" '{
+        for (i = 1; i <= NF; ++i) { split($i, kv, "="); v[kv[1]] = kv[2] }
+        printf "%s,%s,%s,%.1f,%s,%s,%s,%s,%s\n", s, th, m, v["rps"], v["p50_us"], v["p99_us"], v["p999_us"], v["err"], cpu
+    }'
+}
+
+echo "server,threads,mix,rps,p50_us,p99_us,p999_us,errors,cpu_cores" > "$OUT"
+echo "threads=[$THREADS_LIST] seconds=$SECS connections=$CONNS"
+printf "  %-8s %7s %-10s %9s %9s %9s %9s %6s %6s\n" server threads mix req/s p50_us p99_us p999_us err cores
+for mix in mix_cheap.txt mix.txt mix_heavy.txt; do
+    for threads in $THREADS_LIST; do
+        for server in server8 server9; do
+            row=$(run "$server" "$threads" "$mix")
+            echo "$row" >> "$OUT"
+            echo "$row" | awk -F, '{ printf "  %-8s %7s %-10s %9s %9s %9s %9s %6s %6s\n", $1, $2, $3, $4, $5, $6, $7, $8, $9 }'
+        done
+    done
+done
+echo "wrote $OUT"
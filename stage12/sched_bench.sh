@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+# Cheap-query latency under a mixed load: the stage10/stage11 workload.sh mix
+# (SCC_COUNT + HAM_CYCLE + MAXCLIQUE + NUM_MAXCLIQUES) repeated ROUNDS times
+# concurrently, with the NP-hard requests given a real time budget.
+# Runs each server once with -S fifo and once with -S sejf and prints
+# p50/p99 latency per algorithm.
+#   usage: sched_bench.sh [rounds] [threads]
+set -euo pipefail
+ROUNDS="${1:-20}"
+THREADS="${2:-4}"
+HERE="$(cd "$(dirname "$0")" && pwd)"
+CLIENT="$HERE/../stage7/client7"
+SERVER8="$HERE/../stage8/server8"
+SERVER9="$HERE/../stage9/server9"
+PORT=5611
+
+now_ms(){ echo $(( $(date +%s%N) / 1000000 )); }
+
+# one timed request -> "ALG latency_ms"
+timed(){
+    local alg="$1"; shift
+    local t0; t0=$(now_ms)
+    "$CLIENT" -p "$PORT" "$*" >/dev/null
+    echo "$alg $(( $(now_ms) - t0 ))"
+}
+
+mix(){
+    local i
+    for ((i=0; i<ROUNDS; ++i)); do
+        timed SCC_COUNT      "ALG SCC_COUNT RANDOM n=200 m=800 seed=$i directed=1" &
+        timed HAM_CYCLE      "ALG HAM_CYCLE RANDOM n=40 m=200 seed=$i directed=1 limit=40 timeout_ms=250 step_limit=1000000000" &
+        timed MAXCLIQUE      "ALG MAXCLIQUE RANDOM n=22 m=40 seed=$i directed=0 timeout_ms=200" &
+        timed NUM_MAXCLIQUES "ALG NUM_MAXCLIQUES RANDOM n=22 m=40 seed=$i directed=0 timeout_ms=200" &
+        sleep 0.01
+    done
+    wait
+}
+
+report(){
+    awk '{ print $2 > ("/tmp/sched_bench." $1) }'
+    for alg in SCC_COUNT HAM_CYCLE MAXCLIQUE NUM_MAXCLIQUES; do
+        sort -n "/tmp/sched_bench.$alg" | awk -v a="$alg" '
+            { v[NR]=$1 } END { if (NR==0) exit;
+              p50=v[int((NR-1)*0.50)+1]; p99=v[int((NR-1)*0.99)+1];
+              printf "    %-15s n=%-4d p50=%5dms p99=%5dms\n", a, NR, p50, p99 }'
+        rm -f "/tmp/sched_bench.$alg"
+    done
+}
+
+run(){
+    local label="$1"; shift
+    "$@" -p "$PORT" >/dev/null &
+    local srv=$!
+    sleep 0.4
+    echo "  $label"
+    mix | report
+    kill -INT "$srv" 2>/dev/null || true
+    wait "$srv" 2>/dev/null || true
+    PORT=$((PORT+1))
+}
+
+echo "rounds=$ROUNDS threads=$THREADS"
+for mode in fifo sejf; do
+    run "server8 -S $mode" "$SERVER8" -t "$THREADS" -S "$mode"
+    run "server9 -S $mode" "$SERVER9" -t "$THREADS" -S "$mode"
+done
@@ -0,0 +1,36 @@
+#include "euler_check.hpp"
+#include <vector>
+
+EulerResult euler_check(const CompressedGraph& g) {
+    EulerResult res;
+    res.directed = g.directed;
+
+    if (!g.directed) {
+        if (!connected_ignoring_isolated(g)) {
+            res.reason = "Graph is not connected on its non-isolated vertices.";
+            return res;
+        }
+        for (std::size_t i = 0; i < g.n; ++i) if (g.degree(i) % 2 != 0) {
+            res.reason = "A vertex has odd degree (all degrees must be even).";
+            return res;
+        }
+        res.exists = true;
+        return res;
+    }
+
+    std::vector<std::size_t> in(g.n, 0);
+    for (std::size_t u = 0; u < g.n; ++u) for (int v : g.neighbors(u)) ++in[v];
+    for (std::size_t i = 0; i < g.n; ++i) {
+        std::size_t out = g.degree(i);
+        if (out + in[i] > 0 && out != in[i]) {
+            res.reason = "In-degree != Out-degree for at least one vertex.";
+            return res;
+        }
+    }
+    if (!connected_ignoring_isolated(g)) {
+        res.reason = "Graph is not strongly connected on its non-isolated vertices.";
+        return res;
+    }
+    res.exists = true;
+    return res;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "euler.hpp"
+#include "compressed_graph.hpp"
+
+// Decide only (same conditions and reasons as euler_find, circuit left
+// empty), on a compressed graph too large to hold as a Graph. Kept out of
+// euler.hpp so euler_find's users do not link compressed_graph.cpp.
+EulerResult euler_check(const CompressedGraph& g);
@@ -1,19 +1,33 @@
 #include "algo.hpp"
+#include "derived.hpp"
+#include "arena.hpp"
+#include "reorder.hpp"   // original_id: replies in the caller's vertex ids
+#include "graph_core.hpp"
 #include <queue>
 #include <algorithm>
-#include <functional>
+#include <bit>
 #include <chrono>
+#include <cstdint>
 
 using Clock = std::chrono::steady_clock;
+// temporaries allocate from arena::scratch(); anything kept past the
+// request (DerivedGraph) uses the default resource
+using Adj  = DerivedGraph::Adj;
+using Ints = std::pmr::vector<int>;
 
+// Every search step calls timed_out(); the clock is read once per 64 steps
+// (a read costs about as much as a clique-search step), and once out of time
+// a Budget stays out of time.
 struct Budget {
     Clock::time_point deadline{};
     size_t step_limit{0};
     size_t steps{0};
+    bool expired{false};
     bool timed_out() {
         ++steps;
-        if (step_limit && steps >= step_limit) return true;
-        if (deadline != Clock::time_point{} && Clock::now() >= deadline) return true;
+        if (expired) return true;
+        if (step_limit && steps >= step_limit) return expired = true;
+        if (deadline != Clock::time_point{} && steps % 64 == 1 && Clock::now() >= deadline) return expired = true;
         return false;
     }
 };
@@ -34,62 +48,26 @@ static std::vector<std::size_t> out_deg(const Graph& g){
     for (std::size_t u=0; u<g.n; ++u) d[u] = g.adj[u].size();
     return d;
 }
-static std::vector<std::vector<int>> reverse_adj(const Graph& g){
-    std::vector<std::vector<int>> radj(g.n);
+static Adj reverse_adj(const Graph& g, std::pmr::memory_resource* mr = arena::scratch()){
+    Adj radj(g.n, mr);
     for (std::size_t u=0; u<g.n; ++u)
         for (int v : g.adj[u]) radj[v].push_back((int)u);
     return radj;
 }
 
 // ---------- (v) SCC count (Kosaraju) ----------
-static int count_connected_undirected(const Graph& g){
-    std::vector<char> vis(g.n,0);
-    int comps=0;
-    for (std::size_t s=0; s<g.n; ++s) if (!vis[s]) {
-        ++comps;
-        std::queue<int> q; q.push((int)s); vis[s]=1;
-        while(!q.empty()){
-            int u=q.front(); q.pop();
-            for (int v : g.adj[u]) if(!vis[v]){ vis[v]=1; q.push(v); }
-            if (g.directed) { // add reverse neighbors when graph is directed but we want CC
-                for (std::size_t x=0; x<g.n; ++x)
-                    for (int y : g.adj[x]) if (y==u && !vis[(int)x]){ vis[(int)x]=1; q.push((int)x); }
-            }
-        }
-    }
-    return comps;
-}
-static int count_scc_kosaraju(const Graph& g){
-    if (!g.directed) return count_connected_undirected(g);
-    std::size_t n = g.n;
-    std::vector<char> vis(n,0);
-    std::vector<int> order; order.reserve(n);
-    std::function<void(int)> dfs1 = [&](int u){
-        vis[u]=1;
-        for (int v : g.adj[u]) if(!vis[v]) dfs1(v);
-        order.push_back(u);
-    };
-    for (std::size_t i=0;i<n;++i) if(!vis[i]) dfs1((int)i);
-    auto radj = reverse_adj(g);
-    std::fill(vis.begin(), vis.end(), 0);
-    int comps=0;
-    std::function<void(int)> dfs2 = [&](int u){
-        vis[u]=1;
-        for (int v : radj[u]) if(!vis[v]) dfs2(v);
-    };
-    for (int i=(int)order.size()-1; i>=0; --i) {
-        int u=order[i]; if(!vis[u]){ ++comps; dfs2(u); }
-    }
-    return comps;
+// Runs on the graph frozen (in scratch memory) into its narrowest
+// compile-time layout (graph_core.hpp): no direction test in the loops,
+// 2-byte ids up to 65536 vertices.
+static AlgoResult scc_count(const Graph& g){
+    std::size_t c = core::dispatch(g, arena::scratch(), [](const auto& csr){ return core::components(csr); });
+    if (g.directed) return {true, "SCC count="+std::to_string(c)};
+    return {true, "Graph undirected; connected components="+std::to_string(c)};
 }
 
 struct SccCount : IAlgorithm {
     const char* name() const override { return "SCC_COUNT"; }
-    AlgoResult run(const Graph& g, const KV&){
-        int c = count_scc_kosaraju(g);
-        if (g.directed) return {true, "SCC count="+std::to_string(c)};
-        return {true, "Graph undirected; connected components="+std::to_string(c)};
-    }
+    AlgoResult run(const Graph& g, const KV&){ return scc_count(g); }
 };
 
 // ---------- (iv) Hamiltonian cycle with prechecks + timeout ----------
@@ -104,7 +82,7 @@ static bool ham_cycle_backtrack(const Graph& g, int start, std::vector<int>& pat
     }
     int u = path.back();
     // Order neighbors by smaller degree first (light heuristic)
-    std::vector<int> nbr = g.adj[u];
+    Ints nbr(g.adj[u].begin(), g.adj[u].end(), arena::scratch());
     std::sort(nbr.begin(), nbr.end(), [&](int a, int b){ return g.adj[a].size() < g.adj[b].size(); });
     for (int v : nbr) if (!used[v]) {
         used[v]=1; path.push_back(v);
@@ -114,7 +92,7 @@ static bool ham_cycle_backtrack(const Graph& g, int start, std::vector<int>& pat
     }
     return false;
 }
-static bool quick_ham_impossible(const Graph& g){
+static bool quick_ham_impossible(const Graph& g, const Adj* shared_radj){
     if (!g.directed) {
         // necessary conditions: connected + all degrees >= 2 (Ore/Dirac are stronger but this is cheap)
         // quick connectivity (undirected)
@@ -137,19 +115,21 @@ static bool quick_ham_impossible(const Graph& g){
         while(!st.empty()){ int u=st.back(); st.pop_back(); for(int v:g.adj[u]) if(!vis[v]){ vis[v]=1; st.push_back(v);} }
         for(size_t i=0;i<g.n;++i) if(!vis[i]) return true;
         // reverse
-        auto radj = reverse_adj(g);
+        Adj own(arena::scratch());
+        if (!shared_radj) own = reverse_adj(g);
+        const auto& radj = shared_radj ? *shared_radj : own;
         std::fill(vis.begin(), vis.end(), 0); vis[0]=1; st={0};
         while(!st.empty()){ int u=st.back(); st.pop_back(); for(int v:radj[u]) if(!vis[v]){ vis[v]=1; st.push_back(v);} }
         for(size_t i=0;i<g.n;++i) if(!vis[i]) return true;
         return false;
     }
 }
-static AlgoResult ham_cycle(const Graph& g, const KV& params){
+static AlgoResult ham_cycle(const Graph& g, const KV& params, const Adj* radj = nullptr){
     int limit_n = 18; // cap search size
     if (auto it=params.find("limit"); it!=params.end()) limit_n = std::max(1, std::atoi(it->second.c_str()));
     if ((int)g.n > limit_n) return {true, "HAM: n="+std::to_string(g.n)+" exceeds limit="+std::to_string(limit_n)+" (skip)"};
     if (g.n == 0) return {true, "HAM: trivial YES (empty)"};
-    if (quick_ham_impossible(g)) return {true, "NO Hamilton cycle (quick precheck)"};
+    if (quick_ham_impossible(g, radj)) return {true, "NO Hamilton cycle (quick precheck)"};
 
     Budget B; B.deadline = Clock::now() + std::chrono::milliseconds(get_timeout_ms(params, 300));
     B.step_limit = get_step_limit(params, 800000); // recursion guard
@@ -162,8 +142,8 @@ static AlgoResult ham_cycle(const Graph& g, const KV& params){
     bool ok = ham_cycle_backtrack(g, start, path, used, 1, B);
     if (ok) {
         std::string out = "YES Hamilton cycle: ";
-        for (size_t i=0;i<path.size();++i){ if(i) out+=" -> "; out+=std::to_string(path[i]); }
-        out += " -> " + std::to_string(start);
+        for (size_t i=0;i<path.size();++i){ if(i) out+=" -> "; out+=std::to_string(original_id(path[i])); }
+        out += " -> " + std::to_string(original_id(start));
         return {true, out};
     }
     if (B.timed_out()) return {true, "HAM: TIMEOUT"};
@@ -176,66 +156,137 @@ struct Hamilton : IAlgorithm {
 };
 
 // ---------- (i, ii) Bron–Kerbosch with pivot + pruning + timeout ----------
+// The top level runs in degeneracy order (Eppstein, Löffler & Strash): vertex
+// v starts the cliques whose other members come later in the order, with
+// P = its later neighbours and X = its earlier ones, so no subproblem has more
+// than deg(v) vertices. Graphs of up to kBitsMax vertices are searched on
+// bitsets (pivot counts and intersections are word operations), larger ones
+// on id-sorted vectors.
 struct BKState {
-    const std::vector<std::vector<int>>& adj; // undirected neighbor lists (sorted)
+    const Adj& adj; // undirected neighbor lists (sorted)
     Budget& B;
     int best=0;
     std::vector<int> bestR;
     long long countMaximal=0;
     bool aborted=false;
 };
+constexpr std::size_t kBitsMax = 1024;
+
+static void found_maximal(BKState& st, const Ints& R, bool recordBest){
+    ++st.countMaximal;
+    if (recordBest && (int)R.size() > st.best) { st.best=(int)R.size(); st.bestR.assign(R.begin(), R.end()); }
+}
+
+// vertices in the order of repeatedly removing one of minimum remaining
+// degree (Batagelj–Zaversnik buckets, O(n + m))
+static Ints degeneracy_order(const Adj& A){
+    std::size_t n = A.size(), maxd = 0;
+    Ints deg(n, arena::scratch()), pos(n, arena::scratch()), vert(n, arena::scratch());
+    for (std::size_t v=0; v<n; ++v) { deg[v] = (int)A[v].size(); maxd = std::max(maxd, A[v].size()); }
+    Ints bin(maxd + 1, 0, arena::scratch());
+    for (std::size_t v=0; v<n; ++v) ++bin[(std::size_t)deg[v]];
+    for (std::size_t d=0, start=0; d<=maxd; ++d) { std::size_t c = (std::size_t)bin[d]; bin[d] = (int)start; start += c; }
+    for (std::size_t v=0; v<n; ++v) { pos[v] = bin[(std::size_t)deg[v]]++; vert[(std::size_t)pos[v]] = (int)v; }
+    for (std::size_t d=maxd; d>0; --d) bin[d] = bin[d-1];
+    bin[0] = 0;
+    for (std::size_t i=0; i<n; ++i) {
+        int v = vert[i];
+        for (int u : A[(std::size_t)v]) if (deg[(std::size_t)u] > deg[(std::size_t)v]) {
+            // move u to the front of its bucket, then into the one below
+            std::size_t du = (std::size_t)deg[(std::size_t)u], pu = (std::size_t)pos[(std::size_t)u], pw = (std::size_t)bin[du];
+            int w = vert[pw];
+            if (u != w) { pos[(std::size_t)u] = (int)pw; vert[pu] = w; pos[(std::size_t)w] = (int)pu; vert[pw] = u; }
+            ++bin[du]; --deg[(std::size_t)u];
+        }
+    }
+    return vert;
+}
+
+// The graph as n bitsets of W words: row(i) holds i's neighbours, ids[i] its
+// graph id. Each bk_bits call takes 3W words of `stack` and leaves the rest
+// to its children (a clique has at most n members).
+struct BitSub {
+    std::size_t W;
+    const int* ids;
+    const std::uint64_t* rows;
+    const std::uint64_t* row(std::size_t i) const { return rows + i * W; }
+};
+
+static void bk_bits(BKState& st, const BitSub& s, Ints& R, std::uint64_t* P, std::uint64_t* X,
+                    std::uint64_t* stack, bool recordBest){
+    if (st.B.timed_out()) { st.aborted=true; return; }
+    const std::size_t W = s.W;
+    int pc = 0; bool xany = false;
+    for (std::size_t w=0; w<W; ++w) { pc += std::popcount(P[w]); xany |= X[w] != 0; }
+
+    // Branch & bound: if we cannot beat current best, prune
+    if (recordBest && (int)R.size() + pc <= st.best) return;
+    if (pc == 0) { if (!xany) found_maximal(st, R, recordBest); return; }
+
+    // pivot: the vertex of P ∪ X with most neighbours in P
+    std::size_t u = 0; int maxN = -1;
+    for (std::size_t w=0; w<W && maxN<pc; ++w)
+        for (std::uint64_t b = P[w] | X[w]; b && maxN<pc; b &= b-1) {
+            std::size_t c = w*64 + (std::size_t)std::countr_zero(b);
+            const std::uint64_t* N = s.row(c);
+            int cnt = 0;
+            for (std::size_t j=0; j<W; ++j) cnt += std::popcount(N[j] & P[j]);
+            if (cnt > maxN) { maxN = cnt; u = c; }
+        }
 
-static inline bool is_adj(const std::vector<std::vector<int>>& A, int u, int v){
-    return std::binary_search(A[u].begin(), A[u].end(), v);
+    // candidates = P \ N(u); children get P ∩ N(v), X ∩ N(v)
+    std::uint64_t *cand = stack, *P2 = cand + W, *X2 = P2 + W;
+    const std::uint64_t* Nu = s.row(u);
+    for (std::size_t j=0; j<W; ++j) cand[j] = P[j] & ~Nu[j];
+    for (std::size_t w=0; w<W; ++w)
+        for (std::uint64_t b = cand[w]; b; b &= b-1) {
+            if (st.B.timed_out()) { st.aborted=true; return; }
+            std::size_t v = w*64 + (std::size_t)std::countr_zero(b);
+            const std::uint64_t* Nv = s.row(v);
+            for (std::size_t j=0; j<W; ++j) { P2[j] = P[j] & Nv[j]; X2[j] = X[j] & Nv[j]; }
+            R.push_back(s.ids[v]);
+            bk_bits(st, s, R, P2, X2, stack + 3*W, recordBest);
+            R.pop_back();
+            std::uint64_t bit = b & (~b + 1);
+            P[w] &= ~bit; X[w] |= bit;
+            if (st.aborted) return;
+        }
 }
-// Compute N(v) ∩ S where S is sorted vector
-static std::vector<int> inter_neighbors(const std::vector<std::vector<int>>& A, int v, const std::vector<int>& S){
-    std::vector<int> out; out.reserve(std::min(A[v].size(), S.size()));
+
+// N(v) ∩ S, both sorted
+static Ints inter_neighbors(const Adj& A, int v, const Ints& S){
+    Ints out(S.get_allocator()); out.reserve(std::min(A[v].size(), S.size()));
     auto &Nv = A[v];
     std::set_intersection(Nv.begin(), Nv.end(), S.begin(), S.end(), std::back_inserter(out));
     return out;
 }
 
-static void bk_recurse(BKState& st, std::vector<int>& R, std::vector<int>& P, std::vector<int>& X, bool recordBest){
+// the same search on id-sorted vectors, for graphs over kBitsMax vertices
+static void bk_recurse(BKState& st, Ints& R, Ints& P, Ints& X, bool recordBest){
     if (st.B.timed_out()) { st.aborted=true; return; }
 
     // Branch & bound: if we cannot beat current best, prune
     if (recordBest && (int)R.size() + (int)P.size() <= st.best) return;
+    if (P.empty()) { if (X.empty()) found_maximal(st, R, recordBest); return; }
 
-    if (P.empty() && X.empty()) {
-        // R is maximal clique
-        ++st.countMaximal;
-        if (recordBest && (int)R.size() > st.best) { st.best=(int)R.size(); st.bestR=R; }
-        return;
-    }
-
-    // Choose pivot u from P ∪ X with max neighbors in P
+    // pivot: the vertex of P ∪ X with most neighbours in P (merge-counted)
     int u=-1, maxN=-1;
-    {
-        std::vector<int> U = P; U.insert(U.end(), X.begin(), X.end());
-        for (int cand : U) {
+    for (const Ints* S : {&P, &X})
+        for (auto it = S->begin(); it != S->end() && maxN < (int)P.size(); ++it) {
             int cnt=0;
-            // count neighbors of cand that are in P (two-pointer)
-            auto &Nv = st.adj[cand];
             auto itP = P.begin();
-            for (int w : Nv) {
+            for (int w : st.adj[*it]) {
                 while (itP!=P.end() && *itP < w) ++itP;
-                if (itP!=P.end() && *itP==w) ++cnt;
+                if (itP==P.end()) break;
+                if (*itP==w) ++cnt;
             }
-            if (cnt > maxN) { maxN=cnt; u=cand; }
+            if (cnt > maxN) { maxN=cnt; u=*it; }
         }
-    }
 
     // Candidates = P \ N(u)
-    std::vector<char> isNbr(st.adj.size(), 0);
-    if (u!=-1) for (int v : st.adj[u]) isNbr[v]=1;
-
-    std::vector<int> cand;
+    Ints cand(P.get_allocator());
     cand.reserve(P.size());
-    for (int v : P) if (!(u!=-1 && isNbr[v])) cand.push_back(v);
-
-    // Iterate candidates (smallest degree first often helps)
-    std::sort(cand.begin(), cand.end(), [&](int a,int b){ return st.adj[a].size() < st.adj[b].size(); });
+    std::set_difference(P.begin(), P.end(), st.adj[u].begin(), st.adj[u].end(), std::back_inserter(cand));
 
     for (int v : cand) {
         if (st.B.timed_out()) { st.aborted=true; return; }
@@ -244,16 +295,66 @@ static void bk_recurse(BKState& st, std::vector<int>& R, std::vector<int>& P, st
         auto X2 = inter_neighbors(st.adj, v, X);
         bk_recurse(st, R, P2, X2, recordBest);
         R.pop_back();
-        // move v from P to X
-        P.erase(std::find(P.begin(), P.end(), v));
-        X.push_back(v);
+        // move v from P to X (both sorted)
+        P.erase(std::lower_bound(P.begin(), P.end(), v));
+        X.insert(std::upper_bound(X.begin(), X.end(), v), v);
+        if (st.aborted) return;
+    }
+}
+
+// Every maximal clique once (countMaximal); with recordBest the largest in
+// bestR, pruning branches that cannot beat it.
+static void bk_run(BKState& st, bool recordBest){
+    const Adj& A = st.adj;
+    const std::size_t n = A.size();
+    Ints R(arena::scratch());
+    if (n == 0) { found_maximal(st, R, recordBest); return; }   // the empty clique
+    Ints order = degeneracy_order(A), rank(n, arena::scratch());
+    for (std::size_t i=0; i<n; ++i) rank[(std::size_t)order[i]] = (int)i;
+
+    if (n <= kBitsMax) {
+        // bit i of a set is order[i], so v's later neighbours are the bits
+        // of its row above rank[v]
+        const std::size_t W = (n + 63) / 64;
+        std::pmr::vector<std::uint64_t> bits(n*W + 2*W + 3*(n+1)*W, 0, arena::scratch());
+        std::uint64_t *rows = bits.data(), *P = rows + n*W, *X = P + W;
+        for (std::size_t i=0; i<n; ++i)
+            for (int x : A[(std::size_t)order[i]]) {
+                std::size_t j = (std::size_t)rank[(std::size_t)x];
+                rows[i*W + j/64] |= std::uint64_t(1) << (j % 64);
+            }
+        const BitSub sub{W, order.data(), rows};
+        for (std::size_t i=0; i<n; ++i) {
+            if (st.B.timed_out()) { st.aborted=true; return; }
+            const std::uint64_t* Ni = sub.row(i);
+            int pc = 0;
+            for (std::size_t w=0; w<W; ++w) {
+                std::uint64_t above = w > i/64 ? ~std::uint64_t(0) : w < i/64 ? 0 : ~std::uint64_t(0) << (i % 64) << 1;
+                P[w] = Ni[w] & above; X[w] = Ni[w] & ~above;
+                pc += std::popcount(P[w]);
+            }
+            if (recordBest && 1 + pc <= st.best) continue;
+            R.assign(1, order[i]);
+            bk_bits(st, sub, R, P, X, X + W, recordBest);
+            if (st.aborted) return;
+        }
+        return;
+    }
+
+    for (int v : order) {
+        if (st.B.timed_out()) { st.aborted=true; return; }
+        Ints P(arena::scratch()), X(arena::scratch());
+        for (int w : A[(std::size_t)v]) (rank[(std::size_t)w] > rank[(std::size_t)v] ? P : X).push_back(w);
+        if (recordBest && 1 + (int)P.size() <= st.best) continue;
+        R.assign(1, v);
+        bk_recurse(st, R, P, X, recordBest);
         if (st.aborted) return;
     }
 }
 
-static std::vector<std::vector<int>> make_adj_undirected(const Graph& g){
+static Adj make_adj_undirected(const Graph& g, std::pmr::memory_resource* mr = arena::scratch()){
     // Treat edges as undirected (needed for clique problems)
-    std::vector<std::vector<int>> A(g.n);
+    Adj A(g.n, mr);
     for (std::size_t u=0; u<g.n; ++u) {
         for (int v : g.adj[u]) {
             A[u].push_back(v);
@@ -267,44 +368,59 @@ static std::vector<std::vector<int>> make_adj_undirected(const Graph& g){
     return A;
 }
 
-struct MaxClique : IAlgorithm {
-    const char* name() const override { return "MAXCLIQUE"; }
-    AlgoResult run(const Graph& g, const KV& params){
-        auto A = make_adj_undirected(g);
-        // initial P = all vertices sorted by ascending deg (degeneracy-ish)
-        std::vector<int> P(g.n), X, R; for (size_t i=0;i<g.n;++i) P[i]=(int)i;
-        std::sort(P.begin(), P.end(), [&](int a,int b){ return A[a].size() < A[b].size(); });
+// A: make_adj_undirected(g)
+static AlgoResult max_clique(const Graph&, const Adj& A, const KV& params){
+    Budget B; B.deadline = Clock::now() + std::chrono::milliseconds(get_timeout_ms(params, 300));
+    B.step_limit = get_step_limit(params, 800000);
 
-        Budget B; B.deadline = Clock::now() + std::chrono::milliseconds(get_timeout_ms(params, 300));
-        B.step_limit = get_step_limit(params, 800000);
+    BKState st{A, B};
+    bk_run(st, /*recordBest=*/true);
 
-        BKState st{A, B};
-        bk_recurse(st, R, P, X, /*recordBest=*/true);
+    if (st.aborted) return {true, "MAXCLIQUE: TIMEOUT (current best="+std::to_string(st.best)+")"};
+    std::string out = "MaxClique size=" + std::to_string(st.best) + " example:";
+    for (size_t i=0;i<st.bestR.size();++i){ out += (i? " ":" "); out += std::to_string(original_id(st.bestR[i])); }
+    return {true, out};
+}
 
-        if (st.aborted) return {true, "MAXCLIQUE: TIMEOUT (current best="+std::to_string(st.best)+")"};
-        std::string out = "MaxClique size=" + std::to_string(st.best) + " example:";
-        for (size_t i=0;i<st.bestR.size();++i){ out += (i? " ":" "); out += std::to_string(st.bestR[i]); }
-        return {true, out};
-    }
+static AlgoResult num_max_cliques(const Graph&, const Adj& A, const KV& params){
+    Budget B; B.deadline = Clock::now() + std::chrono::milliseconds(get_timeout_ms(params, 300));
+    B.step_limit = get_step_limit(params, 800000);
+
+    BKState st{A, B};
+    bk_run(st, /*recordBest=*/false);
+
+    if (st.aborted) return {true, "NUM_MAXCLIQUES: TIMEOUT (count so far="+std::to_string(st.countMaximal)+")"};
+    return {true, "Maximal cliques count="+std::to_string(st.countMaximal)};
+}
+
+struct MaxClique : IAlgorithm {
+    const char* name() const override { return "MAXCLIQUE"; }
+    AlgoResult run(const Graph& g, const KV& params){ return max_clique(g, make_adj_undirected(g), params); }
 };
 
 struct NumMaxCliques : IAlgorithm {
     const char* name() const override { return "NUM_MAXCLIQUES"; }
-    AlgoResult run(const Graph& g, const KV& params){
-        auto A = make_adj_undirected(g);
-        std::vector<int> P(g.n), X, R; for (size_t i=0;i<g.n;++i) P[i]=(int)i;
-        std::sort(P.begin(), P.end(), [&](int a,int b){ return A[a].size() < A[b].size(); });
-
-        Budget B; B.deadline = Clock::now() + std::chrono::milliseconds(get_timeout_ms(params, 300));
-        B.step_limit = get_step_limit(params, 800000);
+    AlgoResult run(const Graph& g, const KV& params){ return num_max_cliques(g, make_adj_undirected(g), params); }
+};
 
-        BKState st{A, B};
-        bk_recurse(st, R, P, X, /*recordBest=*/false);
+// ---------- shared derived structures (BATCH) ----------
+const DerivedGraph::Adj& DerivedGraph::reverse() const {
+    std::call_once(rev_once_, [this]{ rev_ = reverse_adj(*g_, std::pmr::get_default_resource()); });
+    return rev_;
+}
+const DerivedGraph::Adj& DerivedGraph::undirected() const {
+    std::call_once(und_once_, [this]{ und_ = make_adj_undirected(*g_, std::pmr::get_default_resource()); });
+    return und_;
+}
 
-        if (st.aborted) return {true, "NUM_MAXCLIQUES: TIMEOUT (count so far="+std::to_string(st.countMaximal)+")"};
-        return {true, "Maximal cliques count="+std::to_string(st.countMaximal)};
-    }
-};
+AlgoResult run_with_derived(const std::string& alg, const DerivedGraph& d, const KV& params){
+    const Graph& g = d.graph();
+    if (alg == "SCC_COUNT")      return scc_count(g);
+    if (alg == "HAM_CYCLE")      return ham_cycle(g, params, g.directed ? &d.reverse() : nullptr);
+    if (alg == "MAXCLIQUE")      return max_clique(g, d.undirected(), params);
+    if (alg == "NUM_MAXCLIQUES") return num_max_cliques(g, d.undirected(), params);
+    return {false, "unknown algorithm"};
+}
 
 IAlgorithm* make_algorithm(const std::string& name){
     if (name == "SCC_COUNT")      return new SccCount();
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+// Request-scoped allocation.
+//
+// Algorithm temporaries (reverse lists, the undirected copy, BK candidate
+// sets) come from scratch(), a per-thread unsynchronized pool: blocks are
+// recycled across requests without touching malloc or any lock.
+// trim_scratch() after a request returns the pool to the heap once it holds
+// more than `keep`, so one huge request does not pin memory on a worker.
+//
+// enable(false) (server -A) sends them to the global heap instead, for
+// comparison.
+//
+// Graph arenas are out of scope: every Graph, request-owned or not, is built
+// on the global heap.
+namespace arena {
+
+inline std::atomic<bool>& enabled_flag(){ static std::atomic<bool> on{true}; return on; }
+inline bool enabled(){ return enabled_flag().load(std::memory_order_relaxed); }
+inline void enable(bool on){ enabled_flag().store(on, std::memory_order_relaxed); }
+
+// upstream of the scratch pool: the heap, counting what the pool holds
+class Counting : public std::pmr::memory_resource {
+public:
+    std::size_t held() const { return held_; }
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, align);
+        held_ += bytes;
+        return p;
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        held_ -= bytes;
+    }
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+    std::size_t held_ = 0;
+};
+
+struct Scratch {
+    Counting heap;
+    std::pmr::unsynchronized_pool_resource pool{&heap};
+};
+inline Scratch& this_thread(){ thread_local Scratch s; return s; }
+
+// Memory for temporaries that die before the current request returns, on
+// this thread.
+inline std::pmr::memory_resource* scratch(){
+    return enabled() ? &this_thread().pool : std::pmr::new_delete_resource();
+}
+
+inline void trim_scratch(std::size_t keep = std::size_t(64) << 20){
+    Scratch& s = this_thread();
+    if (s.heap.held() > keep) s.pool.release();
+}
+
+} // namespace arena
@@ -30,7 +30,9 @@ int main(int argc, char** argv){
     std::string line=req+"\n";
     if(send(sfd,line.c_str(),line.size(),0)<0){ perror("send"); return 1; }
 
-    char buf[8192]; ssize_t r=recv(sfd,buf,sizeof(buf)-1,0);
-    if(r>0){ buf[r]='\0'; std::cout<<buf; }
+    shutdown(sfd,SHUT_WR);
+    // the server closes after its reply, which may span several reads
+    char buf[8192]; ssize_t r;
+    while((r=recv(sfd,buf,sizeof(buf),0))>0) std::cout.write(buf,r);
     close(sfd); return 0;
 }
@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "algo.hpp"
+
+// End-to-end request deadlines. A request that carries timeout_ms gets an
+// absolute deadline when its connection is accepted; whatever time it spends
+// parsing and queueing is taken out of the budget the algorithm sees.
+using DeadlineClock = std::chrono::steady_clock;
+
+// accepted + timeout_ms, or time_point{} (no deadline) without timeout_ms
+inline DeadlineClock::time_point deadline_from(const KV& params, DeadlineClock::time_point accepted){
+    auto it = params.find("timeout_ms");
+    if (it == params.end()) return {};
+    return accepted + std::chrono::milliseconds(std::max(1, std::atoi(it->second.c_str())));
+}
+
+// Rewrite timeout_ms with the time left before `deadline`, rounded up to
+// whole milliseconds (so at least 1). Returns false once the deadline has
+// passed: the request should fail with ERR DEADLINE.
+inline bool apply_remaining(KV& params, DeadlineClock::time_point deadline){
+    if (deadline == DeadlineClock::time_point{}) return true;
+    auto now = DeadlineClock::now();
+    if (deadline <= now) return false;
+    params["timeout_ms"] = std::to_string(std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+    return true;
+}
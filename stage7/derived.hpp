@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "algo.hpp"
+
+// Structures several algorithms derive from the same graph: the reverse
+// adjacency (HAM prechecks) and the sorted undirected adjacency (both
+// clique searches). Each is built on first use, once, even when several
+// threads ask at the same time; afterwards it is read-only and shared.
+class DerivedGraph {
+public:
+    using Adj = std::pmr::vector<std::pmr::vector<int>>;
+
+    explicit DerivedGraph(std::shared_ptr<const Graph> g) : g_(std::move(g)) {}
+    const Graph& graph() const { return *g_; }
+    const Adj& reverse() const;      // radj[v] = { u : u->v }
+    const Adj& undirected() const;   // sorted, deduplicated, edges both ways
+
+private:
+    std::shared_ptr<const Graph> g_;
+    mutable std::once_flag rev_once_, und_once_;
+    mutable Adj rev_, und_;
+};
+
+// Same reply as make_algorithm(alg)->run(d.graph(), params), reusing d's
+// derived structures; ok=false for an unknown algorithm.
+AlgoResult run_with_derived(const std::string& alg, const DerivedGraph& d, const KV& params);
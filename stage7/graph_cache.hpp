@@ -0,0 +1,228 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <sys/stat.h>
+#include "graph.hpp"
+#include "csr_snapshot.hpp"
+#include "edge_import.hpp"
+#include "reorder.hpp"
+
+// ---------- exact G(n,m) generator (Robert Floyd), same mapping as stage7 ----------
+inline std::pair<int,int> gnm_id_to_pair_directed(std::size_t n, unsigned long long id){
+    unsigned long long row=id/(n-1), col=id%(n-1);
+    int u=(int)row, v=(int)col; if (v>=u) ++v; return {u,v};
+}
+inline std::pair<int,int> gnm_id_to_pair_undirected(std::size_t n, unsigned long long id){
+    unsigned long long u=0, rem=id, len=n-1;
+    while (rem>=len){ rem-=len; ++u; --len; }
+    unsigned long long v=u+1+rem; return {(int)u,(int)v};
+}
+inline std::vector<unsigned long long> gnm_sample_ids(unsigned long long N, unsigned long long m, std::mt19937& rng){
+    std::unordered_set<unsigned long long> S; S.reserve((size_t)m*2+16);
+    std::uniform_int_distribution<unsigned long long> dist;
+    for (unsigned long long j=N-m; j<N; ++j){
+        unsigned long long t = dist(rng, decltype(dist)::param_type(0, j));
+        if (!S.insert(t).second) S.insert(j);
+    }
+    return std::vector<unsigned long long>(S.begin(), S.end());
+}
+inline void generate_Gnm(Graph& g, std::size_t target_m, unsigned seed){
+    if (g.n==0 || target_m==0) return;
+    unsigned long long N = g.directed ? (unsigned long long)g.n*(g.n-1)
+                                      : (unsigned long long)g.n*(g.n-1)/2ULL;
+    if (target_m > N) target_m = (std::size_t)N;
+    std::mt19937 rng(seed);
+    auto ids = gnm_sample_ids(N, target_m, rng);
+    for (auto id : ids){
+        auto [u,v] = g.directed ? gnm_id_to_pair_directed(g.n,id) : gnm_id_to_pair_undirected(g.n,id);
+        g.add_edge(u, v);
+    }
+}
+
+// Requests hold graphs through this handle: moving a request between queues
+// copies a pointer, and a cached graph is shared by every request using it.
+using GraphRef = std::shared_ptr<const Graph>;
+
+// The ids an imported graph's vertices had in their file (SNAP relabelling,
+// ImportStats::labels); null when they are 0..n-1.
+using FileIds = std::shared_ptr<const std::vector<long long>>;
+
+// approximate heap footprint of a Graph
+inline std::size_t graph_bytes(const Graph& g){
+    std::size_t b = sizeof(Graph) + g.adj.capacity() * sizeof(Graph::AdjList);
+    for (auto& a : g.adj) b += a.capacity() * sizeof(int);
+    return b;
+}
+
+// ---------- generated-graph cache ----------
+// Immutable G(n,m) graphs keyed by (n, m, seed, directed), and graphs read
+// from snapshot files, LRU-evicted once their total footprint passes
+// max_bytes. Eviction only drops the cache's reference; requests still
+// running keep theirs. Building happens outside the lock, so two concurrent
+// misses on one key may both build it (the first insert wins). max_bytes == 0
+// disables caching.
+// A graph larger than max_bytes would be rebuilt on every request (a big
+// snapshot re-read, checksummed and copied each time), so the most recent one
+// is kept aside, outside the byte budget, until another replaces it.
+class GraphCache {
+public:
+    struct Stats { unsigned long long hits, misses; std::size_t entries, bytes, capacity; };
+
+    explicit GraphCache(std::size_t max_bytes = 128u << 20) : capacity_(max_bytes) {}
+    void resize(std::size_t max_bytes){ std::lock_guard<std::mutex> lk(m_); capacity_ = max_bytes; evict(); if (!capacity_) big_ = {}; }
+
+    GraphRef get(std::size_t n, std::size_t m, unsigned seed, bool directed){
+        std::string key = std::to_string(n)+" "+std::to_string(m)+" "+std::to_string(seed)+(directed?" d":" u");
+        return get_or_build(std::move(key), [&]{
+            auto g = std::make_shared<Graph>(n, directed);
+            generate_Gnm(*g, m, seed);
+            return GraphRef(std::move(g));
+        });
+    }
+
+    // `build` runs on a miss; a nullptr result is returned and not cached.
+    // With `ids`, the FileIds build() leaves there are kept with the graph and
+    // handed back on every hit.
+    GraphRef get_or_build(std::string key, const std::function<GraphRef()>& build, FileIds* ids = nullptr){
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            const Entry* e = nullptr;
+            if (auto it = index_.find(key); it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                e = &*it->second;
+            } else if (big_.g && big_.key == key) e = &big_;
+            if (e) {
+                ++hits_;
+                if (ids) *ids = e->ids;
+                return e->g;
+            }
+            ++misses_;
+        }
+        GraphRef ref = build();
+        FileIds built_ids = ids ? *ids : nullptr;
+
+        std::lock_guard<std::mutex> lk(m_);
+        if (!ref || capacity_ == 0) return ref;
+        if (auto it = index_.find(key); it != index_.end()) { if (ids) *ids = it->second->ids; return it->second->g; }
+        std::size_t sz = graph_bytes(*ref) + (built_ids ? built_ids->size() * sizeof(long long) : 0);
+        if (sz > capacity_) { big_ = Entry{std::move(key), ref, built_ids, sz}; return ref; }
+        lru_.push_front(Entry{key, ref, built_ids, sz});
+        index_.emplace(std::move(key), lru_.begin());
+        bytes_ += sz;
+        evict();
+        return ref;
+    }
+
+    void clear(){ std::lock_guard<std::mutex> lk(m_); lru_.clear(); index_.clear(); bytes_ = 0; big_ = {}; }
+
+    Stats stats(){
+        std::lock_guard<std::mutex> lk(m_);
+        return Stats{hits_, misses_, index_.size(), bytes_, capacity_};
+    }
+
+private:
+    struct Entry { std::string key; GraphRef g; FileIds ids; std::size_t bytes; };
+    void evict(){   // m_ held
+        while (bytes_ > capacity_ && !lru_.empty()) {
+            bytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    std::mutex m_;
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    Entry big_;   // the latest graph over capacity_, not counted in bytes_
+    std::size_t bytes_ = 0, capacity_;
+    unsigned long long hits_ = 0, misses_ = 0;
+};
+
+// FILE path=..: a CSR snapshot (see csr_snapshot.hpp), mapped and turned
+// into a Graph once per file version (device, inode, size, mtime) and then
+// shared through the cache like a generated graph. `version` gets that
+// identity for result-cache keys. The algorithms need a Graph, so the
+// mapping is only held while converting; the page cache keeps the file warm
+// for other processes. The structure is always checked; verify=0 skips only
+// the checksum pass.
+inline bool file_version(const std::string& path, std::string& version, std::string& err){
+    struct stat st{};
+    if (path.empty() || ::stat(path.c_str(), &st) != 0) { err = "cannot open " + path; return false; }
+    version = "f=" + std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" + std::to_string(st.st_size)
+            + ":" + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+    return true;
+}
+
+inline GraphRef snapshot_graph(GraphCache& c, const std::string& path, bool verify, std::string& version, std::string& err){
+    if (!file_version(path, version, err)) return nullptr;
+    return c.get_or_build("file " + path + " " + version, [&]() -> GraphRef {
+        auto s = CsrSnapshot::open(path, err, verify);
+        if (!s) return nullptr;
+        return std::make_shared<const Graph>(s->to_graph());
+    });
+}
+
+// Same for a SNAP / DIMACS / METIS edge-list file, parsed by the parallel
+// importer (edge_import.hpp); the version also covers format and direction.
+// `ids` gets the file ids of a relabelled SNAP graph (null otherwise), for a
+// LabelScope around the run.
+inline GraphRef imported_graph(GraphCache& c, const std::string& path, const ImportOptions& opts,
+                               std::string& version, FileIds& ids, std::string& err){
+    ids = nullptr;
+    if (!file_version(path, version, err)) return nullptr;
+    version += std::string(" fmt=") + edge_format_name(opts.format) + " d=" + (opts.directed ? "1" : "0");
+    return c.get_or_build("import " + path + " " + version, [&]() -> GraphRef {
+        ImportStats st;
+        auto g = import_edge_file(path, opts, st, err);
+        if (g && !st.labels.empty()) ids = std::make_shared<const std::vector<long long>>(std::move(st.labels));
+        return g;
+    }, &ids);
+}
+
+// reorder=..: permuted copies (reorder.hpp) of shared graphs, so a cached
+// RANDOM/FILE graph or a session graph is relabelled once per ordering rather
+// than per request. Entries are keyed by the source graph's identity and only
+// hold it weakly: once every other holder has dropped the source, its copies
+// are dropped too. At most `max_entries` are kept, least recently used first
+// out; like GraphCache, building happens outside the lock.
+class ReorderCache {
+public:
+    explicit ReorderCache(std::size_t max_entries = 16) : capacity_(max_entries) {}
+
+    std::shared_ptr<const Reordered> get(const GraphRef& src, Reorder r){
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (auto it = find(src, r); it != lru_.end()) { lru_.splice(lru_.begin(), lru_, it); return it->p; }
+        }
+        auto p = reorder_graph(*src, r);
+
+        std::lock_guard<std::mutex> lk(m_);
+        if (auto it = find(src, r); it != lru_.end()) return it->p;
+        lru_.push_front(Entry{src, r, p});
+        lru_.remove_if([](const Entry& e){ return e.src.expired(); });
+        while (lru_.size() > capacity_) lru_.pop_back();
+        return p;
+    }
+
+    void clear(){ std::lock_guard<std::mutex> lk(m_); lru_.clear(); }
+
+private:
+    struct Entry { std::weak_ptr<const Graph> src; Reorder r; std::shared_ptr<const Reordered> p; };
+    std::list<Entry>::iterator find(const GraphRef& src, Reorder r){   // m_ held
+        for (auto it = lru_.begin(); it != lru_.end(); ++it)
+            if (it->r == r && !it->src.owner_before(src) && !src.owner_before(it->src) && !it->src.expired()) return it;
+        return lru_.end();
+    }
+
+    std::mutex m_;
+    std::list<Entry> lru_;
+    std::size_t capacity_;
+};
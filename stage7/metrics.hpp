@@ -0,0 +1,176 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// ---------- latency histograms ----------
+// HDR-style log-linear buckets over microseconds: exact below 8us, then 8
+// sub-buckets per power of two (<= 12.5% relative error) up to 2^36us. Each
+// histogram is split into stripes picked per thread, so recording is a few
+// relaxed atomic adds on a cache line other threads rarely touch; readers sum
+// the stripes.
+class LatencyHistogram {
+public:
+    static constexpr int kSub = 8, kMaxPow = 36;
+    static constexpr int kBuckets = (kMaxPow - 2) * kSub + kSub;
+    static constexpr int kStripes = 8;
+
+    struct Snapshot {
+        std::uint64_t count = 0, sum_us = 0, max_us = 0;
+        std::uint64_t p50 = 0, p90 = 0, p99 = 0, p999 = 0;
+    };
+
+    void record_us(std::uint64_t us){
+        Stripe& s = stripes_[stripe()];
+        s.buckets[index(us)].fetch_add(1, std::memory_order_relaxed);
+        s.count.fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(us, std::memory_order_relaxed);
+        std::uint64_t m = s.max.load(std::memory_order_relaxed);
+        while (us > m && !s.max.compare_exchange_weak(m, us, std::memory_order_relaxed)) {}
+    }
+    template <typename Dur>
+    void record(Dur d){ record_us((std::uint64_t)std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(d).count())); }
+
+    Snapshot snapshot() const {
+        Snapshot out;
+        std::vector<std::uint64_t> b(kBuckets, 0);
+        for (auto& s : stripes_) {
+            for (int i = 0; i < kBuckets; ++i) b[i] += s.buckets[i].load(std::memory_order_relaxed);
+            out.count += s.count.load(std::memory_order_relaxed);
+            out.sum_us += s.sum.load(std::memory_order_relaxed);
+            out.max_us = std::max(out.max_us, s.max.load(std::memory_order_relaxed));
+        }
+        std::uint64_t total = 0;
+        for (auto c : b) total += c;
+        auto q = [&](double f){
+            std::uint64_t want = std::max<std::uint64_t>(1, (std::uint64_t)std::ceil(f * (double)total)), seen = 0;
+            for (int i = 0; i < kBuckets; ++i) { seen += b[i]; if (seen >= want) return std::min(upper(i), out.max_us); }
+            return out.max_us;
+        };
+        if (total) { out.p50 = q(0.50); out.p90 = q(0.90); out.p99 = q(0.99); out.p999 = q(0.999); }
+        return out;
+    }
+
+private:
+    static int index(std::uint64_t v){
+        if (v < (std::uint64_t)kSub) return (int)v;
+        int msb = 63 - __builtin_clzll(v);
+        if (msb >= kMaxPow) return kBuckets - 1;
+        int sub = (int)(v >> (msb - 3)) & (kSub - 1);
+        return (msb - 2) * kSub + sub;
+    }
+    // largest value that lands in bucket i
+    static std::uint64_t upper(int i){
+        if (i < kSub) return (std::uint64_t)i;
+        int msb = i / kSub + 2, sub = i % kSub;
+        return ((std::uint64_t)(kSub + sub + 1) << (msb - 3)) - 1;
+    }
+    static int stripe(){
+        static std::atomic<int> next{0};
+        thread_local int id = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+        return id;
+    }
+    struct alignas(64) Stripe {
+        std::atomic<std::uint64_t> buckets[kBuckets]{};
+        std::atomic<std::uint64_t> count{0}, sum{0}, max{0};
+    };
+    Stripe stripes_[kStripes];
+};
+
+// ---------- registry ----------
+// Histograms are registered while the server starts; afterwards the set is
+// fixed, so looking one up or recording into it takes no lock.
+class Metrics {
+public:
+    LatencyHistogram& add(const std::string& name){
+        hists_.emplace_back(name, std::make_unique<LatencyHistogram>());
+        index_[name] = hists_.back().second.get();
+        return *hists_.back().second;
+    }
+    LatencyHistogram* find(const std::string& name) const {
+        auto it = index_.find(name);
+        return it == index_.end() ? nullptr : it->second;
+    }
+
+    // " lat.<name>.count=.. lat.<name>.p50_us=.. ..." (appended to a STATS line)
+    std::string text() const {
+        std::string out;
+        for (auto& [name, h] : hists_) {
+            auto s = h->snapshot();
+            std::string t = " lat." + name + ".";
+            out += t+"count="+std::to_string(s.count) + t+"mean_us="+std::to_string(s.count ? s.sum_us / s.count : 0)
+                 + t+"p50_us="+std::to_string(s.p50) + t+"p90_us="+std::to_string(s.p90)
+                 + t+"p99_us="+std::to_string(s.p99) + t+"max_us="+std::to_string(s.max_us);
+        }
+        return out;
+    }
+    // {"name":{"count":..,"p50_us":..,...},...}
+    std::string json() const {
+        std::string out = "{";
+        for (auto& [name, h] : hists_) {
+            auto s = h->snapshot();
+            if (out.size() > 1) out += ',';
+            out += "\"" + name + "\":{\"count\":" + std::to_string(s.count) + ",\"sum_us\":" + std::to_string(s.sum_us)
+                 + ",\"p50_us\":" + std::to_string(s.p50) + ",\"p90_us\":" + std::to_string(s.p90)
+                 + ",\"p99_us\":" + std::to_string(s.p99) + ",\"p999_us\":" + std::to_string(s.p999)
+                 + ",\"max_us\":" + std::to_string(s.max_us) + "}";
+        }
+        return out + "}";
+    }
+    // Prometheus text exposition: one summary per histogram
+    std::string prometheus(const std::string& prefix) const {
+        std::string m = prefix + "_latency_us";
+        std::string out = "# HELP " + m + " request latency by phase, microseconds\n# TYPE " + m + " summary\n";
+        for (auto& [name, h] : hists_) {
+            auto s = h->snapshot();
+            std::string l = "{phase=\"" + name + "\"";
+            const std::pair<const char*, std::uint64_t> qs[] = {{"0.5", s.p50}, {"0.9", s.p90}, {"0.99", s.p99}, {"0.999", s.p999}};
+            for (auto& [q, v] : qs) out += m + l + ",quantile=\"" + q + "\"} " + std::to_string(v) + "\n";
+            out += m + "_sum" + l + "} " + std::to_string(s.sum_us) + "\n";
+            out += m + "_count" + l + "} " + std::to_string(s.count) + "\n";
+        }
+        return out;
+    }
+
+private:
+    std::deque<std::pair<std::string, std::unique_ptr<LatencyHistogram>>> hists_;
+    std::unordered_map<std::string, LatencyHistogram*> index_;
+};
+
+// Minimal HTTP/1.0 endpoint on 127.0.0.1:port answering every request with
+// body() as Prometheus text. Runs on its own detached thread.
+inline bool serve_prometheus(int port, std::function<std::string()> body){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int yes = 1; setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in a{}; a.sin_family = AF_INET; a.sin_port = htons((uint16_t)port); a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(fd, 16) < 0) { close(fd); return false; }
+    std::thread([fd, body = std::move(body)]{
+        while (true) {
+            int c = accept(fd, nullptr, nullptr);
+            if (c < 0) continue;
+            char buf[1024]; (void)!recv(c, buf, sizeof buf, 0);   // request line and headers: ignored
+            std::string b = body();
+            std::string r = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                          + std::to_string(b.size()) + "\r\n\r\n" + b;
+            for (std::size_t off = 0; off < r.size(); ) { ssize_t w = send(c, r.data()+off, r.size()-off, 0); if (w <= 0) break; off += (std::size_t)w; }
+            close(c);
+        }
+    }).detach();
+    return true;
+}
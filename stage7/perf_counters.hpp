@@ -0,0 +1,152 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <unordered_map>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ---------- hardware performance counters ----------
+// perf_event_open counters for the calling thread, user space only. Each
+// event is opened on its own, so a machine (or VM) without some of them still
+// reports the rest; the software task clock and page-fault counts work even
+// where there is no PMU at all. Counters stay open per thread and are reset
+// and enabled around each measured run: a handful of ioctl()s per run, and
+// nothing at all when counting is off.
+namespace perf {
+
+enum Event { Cycles, Instructions, CacheMisses, BranchMisses, TaskClockNs, PageFaults, kEvents };
+inline const char* event_name(int e){
+    static const char* names[kEvents] = {"cycles", "instructions", "cache_misses", "branch_misses", "task_clock_ns", "page_faults"};
+    return names[e];
+}
+
+struct Sample {
+    std::uint64_t v[kEvents]{};
+    unsigned have = 0;   // bit e set when event e was counted
+    bool has(int e) const { return have >> e & 1u; }
+};
+
+class ThreadCounters {
+public:
+    ThreadCounters(){
+        const std::pair<std::uint32_t, std::uint64_t> cfg[kEvents] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}, {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},   {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}};
+        for (int e = 0; e < kEvents; ++e) {
+            perf_event_attr a{};
+            a.size = sizeof a; a.type = cfg[e].first; a.config = cfg[e].second;
+            a.disabled = 1; a.exclude_kernel = 1; a.exclude_hv = 1;
+            fd_[e] = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+        }
+    }
+    ~ThreadCounters(){ for (int fd : fd_) if (fd >= 0) close(fd); }
+    ThreadCounters(const ThreadCounters&) = delete;
+    ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+    void start(){
+        for (int fd : fd_) if (fd >= 0) { ioctl(fd, PERF_EVENT_IOC_RESET, 0); ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); }
+    }
+    Sample stop(){
+        Sample s;
+        for (int e = 0; e < kEvents; ++e) {
+            if (fd_[e] < 0) continue;
+            ioctl(fd_[e], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_[e], &s.v[e], sizeof s.v[e]) == (ssize_t)sizeof s.v[e]) s.have |= 1u << e;
+        }
+        return s;
+    }
+
+private:
+    int fd_[kEvents];
+};
+
+inline ThreadCounters& this_thread(){ thread_local ThreadCounters c; return c; }
+
+// RAII: counts from construction to stop() when `on`; otherwise free
+class Scope {
+public:
+    explicit Scope(bool on) : on_(on) { if (on_) this_thread().start(); }
+    ~Scope(){ if (on_) this_thread().stop(); }
+    Sample stop(){ if (!on_) return {}; on_ = false; return this_thread().stop(); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    bool on_;
+};
+
+// " perf[cycles=.. instructions=.. ipc=.. ...]" appended to a profiled reply
+inline std::string reply_suffix(const Sample& s){
+    if (!s.have) return " perf[unavailable]";
+    std::string out = " perf[";
+    for (int e = 0; e < kEvents; ++e)
+        if (s.has(e)) { if (out.size() > 6) out += ' '; out += std::string(event_name(e)) + "=" + std::to_string(s.v[e]); }
+    if (s.has(Cycles) && s.has(Instructions) && s.v[Cycles]) {
+        char buf[32]; std::snprintf(buf, sizeof buf, " ipc=%.2f", (double)s.v[Instructions] / (double)s.v[Cycles]);
+        out += buf;
+    }
+    return out + "]";
+}
+
+// Per-algorithm running totals, registered at startup like the latency
+// histograms, so adding a sample is lock-free.
+class Totals {
+public:
+    void add(const std::string& name){ Row& r = rows_.emplace_back(); r.name = name; index_[name] = &r; }
+    void record(const std::string& name, const Sample& s){
+        auto it = index_.find(name);
+        if (it == index_.end() || !s.have) return;
+        Row& r = *it->second;
+        r.runs.fetch_add(1, std::memory_order_relaxed);
+        for (int e = 0; e < kEvents; ++e)
+            if (s.has(e)) r.v[e].fetch_add(s.v[e], std::memory_order_relaxed);
+    }
+    // " perf.<alg>.runs=.. perf.<alg>.cycles=.. ... perf.<alg>.ipc=.." (appended to a STATS line)
+    std::string text() const {
+        std::string out;
+        for (auto& r : rows_) {
+            std::uint64_t runs = r.runs.load(std::memory_order_relaxed);
+            if (!runs) continue;
+            std::string t = " perf." + r.name + ".";
+            out += t + "runs=" + std::to_string(runs);
+            for (int e = 0; e < kEvents; ++e) out += t + event_name(e) + "=" + std::to_string(r.v[e].load(std::memory_order_relaxed));
+            out += t + "ipc=" + ipc(r);
+        }
+        return out;
+    }
+    // {"<alg>":{"runs":..,"cycles":..,...,"ipc":..},...}
+    std::string json() const {
+        std::string out = "{";
+        for (auto& r : rows_) {
+            if (out.size() > 1) out += ',';
+            out += "\"" + r.name + "\":{\"runs\":" + std::to_string(r.runs.load(std::memory_order_relaxed));
+            for (int e = 0; e < kEvents; ++e)
+                out += std::string(",\"") + event_name(e) + "\":" + std::to_string(r.v[e].load(std::memory_order_relaxed));
+            out += ",\"ipc\":" + ipc(r) + "}";
+        }
+        return out + "}";
+    }
+
+private:
+    struct Row {
+        std::string name;
+        std::atomic<std::uint64_t> runs{0};
+        std::atomic<std::uint64_t> v[kEvents]{};
+    };
+    static std::string ipc(const Row& r){
+        std::uint64_t c = r.v[Cycles].load(std::memory_order_relaxed), i = r.v[Instructions].load(std::memory_order_relaxed);
+        char buf[32]; std::snprintf(buf, sizeof buf, "%.2f", c ? (double)i / (double)c : 0.0);
+        return buf;
+    }
+    std::deque<Row> rows_;
+    std::unordered_map<std::string, Row*> index_;
+};
+
+} // namespace perf
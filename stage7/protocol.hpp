@@ -0,0 +1,222 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "algo.hpp"
+#include "graph_cache.hpp"
+#include "sessions.hpp"
+#include "result_cache.hpp"
+
+// ---------- wire protocol pieces shared by the Stage 8 and Stage 9 servers ----------
+// Socket helpers, the edge payload of GRAPH/GRAPHBIN, FILE graphs, and the
+// session commands (LOAD/DROP/ADD_EDGES/REMOVE_EDGES). Every helper that can
+// fail has sent the error line by the time it returns.
+
+inline bool read_line(int fd, std::string& out){
+    out.clear(); char c; ssize_t r;
+    while (true){
+        r = recv(fd, &c, 1, 0);
+        if (r == 0) return false;
+        if (r < 0)  return false;
+        if (c == '\n') break;
+        if (c == '\r') continue;
+        out.push_back(c);
+        if (out.size() > 2'000'000) return false;
+    }
+    return true;
+}
+inline bool read_exact(int fd, void* buf, std::size_t len){
+    char* p = static_cast<char*>(buf);
+    while (len) { ssize_t r = recv(fd, p, len, 0); if (r <= 0) return false; p += r; len -= (std::size_t)r; }
+    return true;
+}
+inline bool send_line(int fd, const std::string& s){
+    size_t left = s.size(); const char* p = s.c_str();
+    while (left) { ssize_t w = send(fd, p, left, 0); if (w <= 0) return false; p += w; left -= w; }
+    return send(fd, "\n", 1, 0) == 1;
+}
+
+inline std::vector<std::string> split_ws(const std::string& line){
+    std::vector<std::string> tok; tok.reserve(16);
+    std::string cur;
+    for (char ch : line){ if (ch==' '||ch=='\t'){ if(!cur.empty()){ tok.push_back(cur); cur.clear(); } } else cur.push_back(ch); }
+    if (!cur.empty()) tok.push_back(cur);
+    return tok;
+}
+
+// gnm_bytes_estimate() for client-supplied sizes: saturates instead of wrapping
+inline std::size_t upload_bytes(std::size_t n, std::size_t m, bool directed){
+    constexpr std::size_t big = std::numeric_limits<std::size_t>::max() / 64;
+    return n > big || m > big ? std::numeric_limits<std::size_t>::max() : gnm_bytes_estimate(n, m, directed);
+}
+
+// Read the m edges that follow a GRAPH ("u v" lines) or GRAPHBIN (m pairs of
+// native int32) header. n and m are checked against `quota` (the session
+// quota for LOAD, the server's -U for a request's own upload) before anything
+// is allocated, and GRAPHBIN is read in fixed-size chunks, so a header alone
+// cannot make the server allocate.
+inline bool read_edges(int cfd, const std::string& mode, const KV& params, std::size_t quota,
+                       GraphRef& out, EdgeHash& eh){
+    std::size_t n=0, m=0; int directed=0;
+    if (!kv_get_size_t(params, "n", n)) { send_line(cfd, "ERR missing n"); return false; }
+    if (!kv_get_size_t(params, "m", m)) { send_line(cfd, "ERR missing m"); return false; }
+    kv_get_int(params, "directed", directed);
+    if (std::size_t need = upload_bytes(n, m, directed!=0); need > quota) {
+        send_line(cfd, "ERR QUOTA need=" + std::to_string(need) + " quota=" + std::to_string(quota));
+        return false;
+    }
+    auto g = std::make_shared<Graph>(n, directed!=0);
+    if (mode == "GRAPHBIN") {
+        std::vector<std::int32_t> buf(2 * std::min<std::size_t>(m, 1 << 16));
+        for (std::size_t done = 0; done < m; ) {
+            std::size_t k = std::min(m - done, buf.size() / 2);
+            if (!read_exact(cfd, buf.data(), 2*k*sizeof(std::int32_t))) { send_line(cfd, "ERR premature end while reading edges"); return false; }
+            for (std::size_t i=0;i<k;++i){ g->add_edge(buf[2*i], buf[2*i+1]); eh.add(buf[2*i], buf[2*i+1]); }
+            done += k;
+        }
+    } else {
+        for (std::size_t i=0;i<m;++i){
+            std::string el; if (!read_line(cfd, el)) { send_line(cfd, "ERR premature end while reading edges"); return false; }
+            int u=-1, v=-1; if (std::sscanf(el.c_str(), "%d %d", &u, &v) != 2) { send_line(cfd, "ERR bad edge format"); return false; }
+            g->add_edge(u, v);
+            eh.add(u, v);
+        }
+    }
+    out = std::move(g);
+    return true;
+}
+
+// Canonical form of the directory FILE may read from (the servers' -F), ""
+// if it does not exist.
+inline std::string file_root(const std::string& dir){
+    char buf[PATH_MAX];
+    return ::realpath(dir.c_str(), buf) ? std::string(buf) : std::string();
+}
+
+// A client's path=, relative to `root` or absolute, as a canonical path that
+// must stay inside root (no "..", no symlink out). An empty root means FILE
+// is off.
+inline bool resolve_file(const std::string& root, const std::string& path, std::string& out, std::string& err){
+    if (root.empty()) { err = "FILE is disabled (start the server with -F <dir>)"; return false; }
+    char buf[PATH_MAX];
+    std::string full = !path.empty() && path[0] == '/' ? path : root + "/" + path;
+    if (path.empty() || !::realpath(full.c_str(), buf)) { err = "cannot open " + path; return false; }
+    out = buf;
+    if (out.compare(0, root.size(), root) != 0 || (out.size() > root.size() && root != "/" && out[root.size()] != '/')) {
+        err = path + ": outside the FILE directory"; return false;
+    }
+    return true;
+}
+
+// FILE path=<file> [verify=0] [format=csr|auto|snap|dimacs|metis] [directed=0|1]:
+// the graph of a CSR snapshot (default) or of an edge-list file imported in
+// parallel, cached per file version in `graphs`; nullptr once the error line has
+// been sent. `root` is the file_root() the server was started with. With
+// `ids`, a relabelled SNAP file's own vertex ids come back there (null for
+// dense files), for the LabelScope the answer is printed under.
+inline GraphRef file_graph(int cfd, const KV& params, GraphCache& graphs, const std::string& root, std::string& version,
+                           FileIds* ids = nullptr){
+    auto it = params.find("path");
+    auto fmt = params.find("format");
+    int verify = 1, directed = 0;
+    kv_get_int(params, "verify", verify);
+    kv_get_int(params, "directed", directed);
+    std::string err, path;
+    if (!resolve_file(root, it == params.end() ? "" : it->second, path, err)) { send_line(cfd, "ERR " + err); return nullptr; }
+    GraphRef g;
+    if (fmt == params.end() || fmt->second == "csr") g = snapshot_graph(graphs, path, verify != 0, version, err);
+    else {
+        ImportOptions io;
+        io.directed = directed != 0;
+        if (!parse_edge_format(fmt->second, io.format)) { send_line(cfd, "ERR format must be csr, auto, snap, dimacs or metis"); return nullptr; }
+        FileIds file_ids;
+        g = imported_graph(graphs, path, io, version, file_ids, err);
+        if (ids) *ids = std::move(file_ids);
+    }
+    if (!g) send_line(cfd, "ERR " + err);
+    return g;
+}
+
+// ADD_EDGES|REMOVE_EDGES <name> m=<k> followed by k "u v" lines: installs a
+// new version of the stored graph.
+inline void update_command(int cfd, const std::vector<std::string>& tok, SessionStore& sessions){
+    std::size_t k = 0;
+    KV params = kv_from_tokens(std::vector<std::string>(tok.begin()+std::min<std::size_t>(2, tok.size()), tok.end()));
+    if (tok.size() < 2 || !kv_get_size_t(params, "m", k)) { send_line(cfd, "ERR expected '" + tok[0] + " <name> m=<k>'"); return; }
+    // k comes from the client: bound it by the quota, and reserve no more than
+    // one chunk up front (the lines have to arrive before they take memory)
+    if (k > sessions.quota() / sizeof(std::pair<int,int>)) {
+        send_line(cfd, "ERR QUOTA m=" + std::to_string(k) + " quota=" + std::to_string(sessions.quota()));
+        return;
+    }
+    std::vector<std::pair<int,int>> edges; edges.reserve(std::min<std::size_t>(k, 1 << 16));
+    for (std::size_t i=0;i<k;++i){
+        std::string el; if (!read_line(cfd, el)) { send_line(cfd, "ERR premature end while reading edges"); return; }
+        int u=-1, v=-1; if (std::sscanf(el.c_str(), "%d %d", &u, &v) != 2) { send_line(cfd, "ERR bad edge format"); return; }
+        edges.emplace_back(u, v);
+    }
+    SessionStore::Entry e; std::size_t changed = 0;
+    switch (sessions.update(tok[1], edges, tok[0] == "REMOVE_EDGES", e, changed)) {
+        case SessionStore::Update::NoSuchGraph: send_line(cfd, "ERR no such graph"); return;
+        case SessionStore::Update::Quota:       send_line(cfd, "ERR QUOTA used=" + std::to_string(sessions.used())
+                                                               + " quota=" + std::to_string(sessions.quota())); return;
+        case SessionStore::Update::Ok:          send_line(cfd, update_line(tok[1], e, changed)); return;
+    }
+}
+
+// LOAD <name> GRAPH|GRAPHBIN|RANDOM|FILE ... / DROP <name> / ADD_EDGES / REMOVE_EDGES.
+// Replies and returns true if `line` was one of them (the caller closes cfd).
+inline bool session_command(int cfd, const std::string& line, SessionStore& sessions, GraphCache& graphs,
+                            const std::string& root){
+    auto tok = split_ws(line);
+    if (tok.empty()) return false;
+    if (tok[0] == "ADD_EDGES" || tok[0] == "REMOVE_EDGES") { update_command(cfd, tok, sessions); return true; }
+    if (tok[0] != "LOAD" && tok[0] != "DROP") return false;
+    if (tok[0] == "DROP") {
+        if (tok.size() != 2) send_line(cfd, "ERR expected 'DROP <name>'");
+        else send_line(cfd, sessions.drop(tok[1]) ? "OK DROPPED " + tok[1] : "ERR no such graph");
+        return true;
+    }
+    if (tok.size() < 3) { send_line(cfd, "ERR expected 'LOAD <name> GRAPH|GRAPHBIN|RANDOM|FILE ...'"); return true; }
+    const std::string& name = tok[1], mode = tok[2];
+    KV params = kv_from_tokens(std::vector<std::string>(tok.begin()+3, tok.end()));
+    GraphRef g;
+    if (mode == "RANDOM") {
+        std::size_t n=0, m=0; unsigned seed=0; int directed=0;
+        if (!kv_get_size_t(params, "n", n) || !kv_get_size_t(params, "m", m)) { send_line(cfd, "ERR missing n or m"); return true; }
+        kv_get_uint(params, "seed", seed);
+        kv_get_int (params, "directed", directed);
+        if (!sessions.fits(upload_bytes(n, m, directed!=0))) {
+            send_line(cfd, "ERR QUOTA used=" + std::to_string(sessions.used()) + " quota=" + std::to_string(sessions.quota()));
+            return true;
+        }
+        g = graphs.get(n, m, seed, directed!=0);
+    } else if (mode == "GRAPH" || mode == "GRAPHBIN") {
+        EdgeHash eh;
+        if (!read_edges(cfd, mode, params, sessions.quota(), g, eh)) return true;
+    } else if (mode == "FILE") {
+        // a stored graph stays in dense ids: ADD_EDGES/REMOVE_EDGES address them
+        std::string version;
+        if (!(g = file_graph(cfd, params, graphs, root, version))) return true;
+    } else { send_line(cfd, "ERR mode must be RANDOM, GRAPH, GRAPHBIN or FILE"); return true; }
+
+    SessionStore::Entry e;
+    if (!sessions.put(name, g, e)) {
+        send_line(cfd, "ERR QUOTA need=" + std::to_string(graph_bytes(*g)) + " used=" + std::to_string(sessions.used())
+                       + " quota=" + std::to_string(sessions.quota()));
+        return true;
+    }
+    send_line(cfd, "OK LOADED " + name + " n=" + std::to_string(g->n) + " m=" + std::to_string(g->m)
+                   + " bytes=" + std::to_string(e.bytes) + " used=" + std::to_string(sessions.used()));
+    return true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include "algo.hpp"
+
+// ---------- result cache keys ----------
+// Every algorithm is deterministic given its graph and parameters. The run
+// budget (timeout_ms / step_limit) only decides whether a run finishes, and
+// unfinished (TIMEOUT) results are never cached, so it is left out of the key.
+inline std::string result_key(const std::string& alg, const std::string& mode, const KV& params,
+                              const std::string& extra = {}){
+    std::vector<std::pair<std::string,std::string>> kv;
+    for (auto& p : params) if (p.first != "timeout_ms" && p.first != "step_limit") kv.push_back(p);
+    std::sort(kv.begin(), kv.end());
+    std::string key = alg + " " + mode;
+    for (auto& [k, v] : kv) { key += ' '; key += k; key += '='; key += v; }
+    if (!extra.empty()) { key += ' '; key += extra; }
+    return key;
+}
+
+// FNV-1a over a GRAPH request's edge list, in the order it was sent (the
+// adjacency order, and so e.g. the reported example clique, depends on it).
+struct EdgeHash {
+    std::uint64_t h = 1469598103934665603ULL;
+    void add(int u, int v){
+        for (int x : {u, v})
+            for (int b = 0; b < 4; ++b) { h ^= (std::uint64_t)((unsigned)x >> (8*b) & 0xff); h *= 1099511628211ULL; }
+    }
+    std::string str() const { char buf[24]; std::snprintf(buf, sizeof buf, "h=%016llx", (unsigned long long)h); return buf; }
+};
+
+// only complete answers are worth keeping (and not ones carrying a run's own
+// profile=1 counters; with profile=1 in their key such lookups always miss)
+inline bool cacheable_reply(const std::string& line){
+    return line.rfind("OK ", 0) == 0 && line.find("TIMEOUT") == std::string::npos
+        && line.find(" perf[") == std::string::npos;
+}
+
+// ---------- sharded LRU result cache ----------
+// Key -> reply line. The key hash picks one of `shards` independently locked
+// LRU lists, each bounded to max_bytes/shards (key + value + a fixed per-entry
+// overhead). max_bytes == 0 disables the cache.
+class ResultCache {
+public:
+    struct Stats {
+        unsigned long long hits, misses, evictions;
+        std::size_t entries, bytes, capacity;
+    };
+
+    explicit ResultCache(std::size_t max_bytes = 64u << 20, std::size_t shards = 16)
+        : shards_(std::max<std::size_t>(1, shards)), capacity_(max_bytes) {}
+
+    void resize(std::size_t max_bytes){ capacity_ = max_bytes; clear(); }
+    bool enabled() const { return capacity_ > 0; }
+
+    bool get(const std::string& key, std::string& out){
+        if (!enabled()) return false;
+        Shard& s = shard(key);
+        {
+            std::lock_guard<std::mutex> lk(s.m);
+            auto it = s.index.find(key);
+            if (it != s.index.end()) {
+                s.lru.splice(s.lru.begin(), s.lru, it->second);   // most recent first
+                out = it->second->second;
+                ++hits_;
+                return true;
+            }
+        }
+        ++misses_;
+        return false;
+    }
+
+    void put(const std::string& key, const std::string& value){
+        if (!enabled()) return;
+        const std::size_t limit = capacity_ / shards_.size(), sz = cost(key, value);
+        if (sz > limit) return;
+        Shard& s = shard(key);
+        std::lock_guard<std::mutex> lk(s.m);
+        if (auto it = s.index.find(key); it != s.index.end()) {
+            s.bytes -= cost(key, it->second->second);
+            s.lru.erase(it->second); s.index.erase(it);
+        }
+        s.lru.emplace_front(key, value);
+        s.index.emplace(key, s.lru.begin());
+        s.bytes += sz;
+        while (s.bytes > limit) {
+            auto& [k, v] = s.lru.back();
+            s.bytes -= cost(k, v);
+            s.index.erase(k); s.lru.pop_back();
+            ++evictions_;
+        }
+    }
+
+    void clear(){
+        for (auto& s : shards_) {
+            std::lock_guard<std::mutex> lk(s.m);
+            s.lru.clear(); s.index.clear(); s.bytes = 0;
+        }
+    }
+
+    Stats stats(){
+        Stats st{hits_.load(), misses_.load(), evictions_.load(), 0, 0, capacity_};
+        for (auto& s : shards_) {
+            std::lock_guard<std::mutex> lk(s.m);
+            st.entries += s.index.size(); st.bytes += s.bytes;
+        }
+        return st;
+    }
+
+    // "OK CACHE hits=.. misses=.. ..." (one line, for the CACHE STATS command)
+    std::string stats_line(){
+        auto s = stats();
+        return "OK CACHE hits=" + std::to_string(s.hits) + " misses=" + std::to_string(s.misses)
+             + " evictions=" + std::to_string(s.evictions) + " entries=" + std::to_string(s.entries)
+             + " bytes=" + std::to_string(s.bytes) + " capacity=" + std::to_string(s.capacity);
+    }
+
+private:
+    using Lru = std::list<std::pair<std::string,std::string>>;
+    struct Shard {
+        std::mutex m;
+        Lru lru;
+        std::unordered_map<std::string, Lru::iterator> index;
+        std::size_t bytes = 0;
+    };
+    static std::size_t cost(const std::string& k, const std::string& v){ return k.size() + v.size() + 96; }
+    Shard& shard(const std::string& key){ return shards_[std::hash<std::string>{}(key) % shards_.size()]; }
+
+    std::vector<Shard> shards_;
+    std::size_t capacity_;
+    std::atomic<unsigned long long> hits_{0}, misses_{0}, evictions_{0};
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include "algo.hpp"
+
+// ---------- request cost model ----------
+// Rough expected run time (microseconds) of one request, from its shape only:
+// linear passes cost ~(n+m), the NP-hard searches are exponential in n but
+// capped by their own budget (timeout_ms / step_limit, same defaults as
+// algorithms.cpp). Only the relative order matters to the scheduler.
+inline double estimate_cost_us(const std::string& alg, std::size_t n, std::size_t m, const KV& params){
+    auto num = [&](const char* k, double def){
+        auto it = params.find(k);
+        return it==params.end() ? def : std::max(1.0, std::atof(it->second.c_str()));
+    };
+    const double linear = 0.02 * (double)(n + m) + 0.1 * (double)m;   // build + one pass
+    const double budget_us = std::min(num("timeout_ms", 300) * 1000.0, num("step_limit", 800000) * 0.05);
+
+    if (alg == "SCC_COUNT") return linear;
+    if (alg == "HAM_CYCLE") {
+        if ((double)n > num("limit", 18)) return linear;            // skipped above limit
+        double avg_deg = n ? 2.0 * (double)m / (double)n : 0.0;
+        if (avg_deg < 2.0) return linear;                             // precheck rejects
+        return linear + std::min(budget_us, 0.05 * std::pow(std::max(avg_deg - 1.0, 1.0), (double)n));
+    }
+    if (alg == "MAXCLIQUE" || alg == "NUM_MAXCLIQUES") {
+        // Moon–Moser: at most 3^(n/3) maximal cliques; sparse graphs do far less
+        double density = n > 1 ? 2.0 * (double)m / ((double)n * (double)(n - 1)) : 0.0;
+        return linear + std::min(budget_us, 0.05 * std::pow(3.0, density * (double)n / 3.0) * (double)n);
+    }
+    return linear;
+}
+
+// Requests below this estimate take the fast lane and never queue behind
+// NP-hard work.
+constexpr double kFastLaneUs = 2000.0;
+
+// ---------- shortest-expected-job-first queue with aging ----------
+// Pops the job with the smallest  cost_us + aging * enqueue_time_us.  Every
+// waiting job ages at the same rate, so the key is fixed at push time and a
+// plain binary heap suffices; with aging=1 an expensive job waits at most
+// about its cost difference behind later cheap ones. aging=0 is pure SEJF;
+// fifo=true orders by arrival only (for comparison runs).
+template <typename Job>
+class SejfQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SejfQueue(double aging = 1.0, bool fifo = false) : aging_(aging), fifo_(fifo) {}
+    void configure(double aging, bool fifo) { aging_ = aging; fifo_ = fifo; }
+
+    void push(Job job, double cost_us) {
+        double t = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+                       Clock::now().time_since_epoch()).count();
+        double key = fifo_ ? t : cost_us + aging_ * t;
+        h_.push_back(Entry{key, cost_us, seq_++, std::move(job)});
+        std::push_heap(h_.begin(), h_.end(), later);
+    }
+    // next job by priority
+    Job pop() {
+        std::pop_heap(h_.begin(), h_.end(), later);
+        Job j = std::move(h_.back().job); h_.pop_back();
+        return j;
+    }
+    // earliest-arrived job (linear scan; used when shedding)
+    Job pop_oldest() {
+        auto it = std::min_element(h_.begin(), h_.end(),
+                                   [](const Entry& a, const Entry& b){ return a.seq < b.seq; });
+        Job j = std::move(it->job);
+        if (it != h_.end() - 1) *it = std::move(h_.back());
+        h_.pop_back();
+        std::make_heap(h_.begin(), h_.end(), later);
+        return j;
+    }
+    // estimated cost of the job pop() would return
+    double top_cost() const { return h_.front().cost; }
+    bool fifo() const { return fifo_; }
+    bool empty() const { return h_.empty(); }
+    std::size_t size() const { return h_.size(); }
+
+private:
+    struct Entry { double key; double cost; unsigned long long seq; Job job; };
+    static bool later(const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key > b.key : a.seq > b.seq;
+    }
+    std::vector<Entry> h_;
+    unsigned long long seq_{0};
+    double aging_;
+    bool fifo_;
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <utility>
+#include <numeric>
+#include <unordered_map>
+#include "graph_cache.hpp"
+
+// lower bound on graph_bytes() of a G(n,m) graph, known before generating it
+inline std::size_t gnm_bytes_estimate(std::size_t n, std::size_t m, bool directed){
+    return sizeof(Graph) + n * sizeof(Graph::AdjList) + (directed ? 1 : 2) * m * sizeof(int);
+}
+
+// ---------- incremental graph summary ----------
+// Kept next to every stored graph so edge insertions update it in
+// near-constant time: weak components through union-find, and the Euler
+// degree condition as the number of vertices that break it (odd degree when
+// undirected, in != out when directed). Union-find cannot undo a union, so a
+// batch that removes edges rebuilds the summary.
+struct GraphSummary {
+    std::vector<int> parent;      // union-find, path halving
+    std::vector<int> balance;     // directed: out - in
+    std::size_t components = 0;   // weakly connected components (isolated vertices count)
+    std::size_t odd = 0;          // vertices violating the Euler degree condition
+
+    static GraphSummary build(const Graph& g){
+        GraphSummary s;
+        s.parent.resize(g.n); std::iota(s.parent.begin(), s.parent.end(), 0);
+        s.components = g.n;
+        if (g.directed) s.balance.assign(g.n, 0);
+        for (std::size_t u=0; u<g.n; ++u)
+            for (int v : g.adj[u]) {
+                s.unite((int)u, v);
+                if (g.directed) { ++s.balance[u]; --s.balance[v]; }
+            }
+        for (std::size_t u=0; u<g.n; ++u)
+            s.odd += g.directed ? s.balance[u] != 0 : (g.adj[u].size() & 1);
+        return s;
+    }
+    int find(int x){
+        while (parent[x] != x) { parent[x] = parent[parent[x]]; x = parent[x]; }
+        return x;
+    }
+    void unite(int a, int b){
+        a = find(a); b = find(b);
+        if (a != b) { parent[a] = b; --components; }
+    }
+    // g.add_edge(u, v) has just added an edge
+    void on_add(const Graph& g, int u, int v){
+        unite(u, v);
+        if (g.directed) {
+            auto flip = [&](int x, int d){ bool was = balance[x] != 0; balance[x] += d; odd += (balance[x] != 0) - was; };
+            flip(u, +1); flip(v, -1);
+        } else {
+            for (int x : {u, v}) odd += (g.adj[x].size() & 1) ? 1 : -1;   // degree parity flipped
+        }
+    }
+    std::size_t bytes() const { return (parent.capacity() + balance.capacity()) * sizeof(int); }
+};
+
+// Applies edge insertions (or deletions) with Graph::add_edge / remove_edge
+// semantics and keeps `s` in step; returns how many edges actually changed.
+inline std::size_t apply_edges(Graph& g, GraphSummary& s, const std::vector<std::pair<int,int>>& edges, bool remove){
+    std::size_t changed = 0;
+    for (auto [u, v] : edges) {
+        if (remove) { changed += g.remove_edge(u, v); continue; }
+        std::size_t before = g.m;
+        g.add_edge(u, v);
+        if (g.m != before) { s.on_add(g, u, v); ++changed; }
+    }
+    if (remove && changed) s = GraphSummary::build(g);
+    return changed;
+}
+
+// ---------- named graph sessions ----------
+// LOAD stores a frozen graph under a name, RUN executes against it and DROP
+// releases it. Workers get the same GraphRef, so a stored graph is never
+// copied; a DROP (or a reload under the same name) while a RUN is in flight
+// just leaves the running request holding the last reference. Every load gets
+// a fresh id, so results cached for an older graph of the same name never
+// match. The sum of stored graph footprints is capped by `quota` bytes.
+//
+// Edge updates are copy-on-write: update() copies the current snapshot, edits
+// the copy without holding the lock and installs it as a new version (a new
+// id). Readers keep whichever snapshot they started with and never wait;
+// concurrent writers to one name retry on the newer version.
+class SessionStore {
+public:
+    struct Entry {
+        GraphRef g;
+        unsigned long long id{0};   // version: unique per LOAD / update
+        std::size_t bytes{0};
+        std::shared_ptr<const GraphSummary> summary;
+    };
+    enum class Update { Ok, NoSuchGraph, Quota };
+
+    explicit SessionStore(std::size_t quota = 256u << 20) : quota_(quota) {}
+    void set_quota(std::size_t q){ std::lock_guard<std::mutex> lk(m_); quota_ = q; }
+
+    // Stores (or replaces) `name`. false when the quota would be exceeded;
+    // the previous graph under that name is kept in that case.
+    bool put(const std::string& name, GraphRef g, Entry& out){
+        auto sum = std::make_shared<const GraphSummary>(GraphSummary::build(*g));
+        std::size_t sz = graph_bytes(*g) + sum->bytes();
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = map_.find(name);
+        std::size_t freed = it == map_.end() ? 0 : it->second.bytes;
+        if (used_ - freed + sz > quota_) return false;
+        used_ = used_ - freed + sz;
+        out = Entry{std::move(g), ++next_id_, sz, std::move(sum)};
+        map_[name] = out;
+        return true;
+    }
+    // New version of `name` with `edges` added (or removed); `changed` gets
+    // the number of edges that made a difference.
+    Update update(const std::string& name, const std::vector<std::pair<int,int>>& edges, bool remove,
+                  Entry& out, std::size_t& changed){
+        while (true) {
+            Entry cur = find(name);
+            if (!cur.g) return Update::NoSuchGraph;
+            auto g = std::make_shared<Graph>(*cur.g);
+            auto sum = std::make_shared<GraphSummary>(*cur.summary);
+            changed = apply_edges(*g, *sum, edges, remove);
+            std::size_t sz = graph_bytes(*g) + sum->bytes();
+
+            std::lock_guard<std::mutex> lk(m_);
+            auto it = map_.find(name);
+            if (it == map_.end()) return Update::NoSuchGraph;
+            if (it->second.id != cur.id) continue;       // another writer won; redo on its version
+            if (used_ - it->second.bytes + sz > quota_) return Update::Quota;
+            used_ = used_ - it->second.bytes + sz;
+            out = Entry{std::move(g), ++next_id_, sz, std::move(sum)};
+            it->second = out;
+            return Update::Ok;
+        }
+    }
+    // cheap pre-check before building a graph of about `bytes`
+    bool fits(std::size_t bytes){ std::lock_guard<std::mutex> lk(m_); return used_ + bytes <= quota_; }
+    // empty Entry (g == nullptr) if there is no such session
+    Entry find(const std::string& name){
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = map_.find(name);
+        return it == map_.end() ? Entry{} : it->second;
+    }
+    bool drop(const std::string& name){
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = map_.find(name);
+        if (it == map_.end()) return false;
+        used_ -= it->second.bytes;
+        map_.erase(it);
+        return true;
+    }
+    std::size_t used(){ std::lock_guard<std::mutex> lk(m_); return used_; }
+    std::size_t quota(){ std::lock_guard<std::mutex> lk(m_); return quota_; }
+    std::size_t count(){ std::lock_guard<std::mutex> lk(m_); return map_.size(); }
+
+private:
+    std::mutex m_;
+    std::unordered_map<std::string, Entry> map_;
+    std::size_t used_ = 0, quota_;
+    unsigned long long next_id_ = 0;
+};
+
+// What the summary already knows, in the algorithm's own words: SCC_COUNT on
+// an undirected graph is the component count.
+inline bool answer_from_summary(const std::string& alg, const SessionStore::Entry& e, std::string& line){
+    if (alg != "SCC_COUNT" || e.g->directed) return false;
+    line = "OK SCC_COUNT Graph undirected; connected components=" + std::to_string(e.summary->components);
+    return true;
+}
+
+// "OK UPDATED <name> version=.. changed=.. n=.. m=.. wcc=.. odd=.." (unbalanced= when directed)
+inline std::string update_line(const std::string& name, const SessionStore::Entry& e, std::size_t changed){
+    return "OK UPDATED " + name + " version=" + std::to_string(e.id) + " changed=" + std::to_string(changed)
+         + " n=" + std::to_string(e.g->n) + " m=" + std::to_string(e.g->m)
+         + " wcc=" + std::to_string(e.summary->components)
+         + (e.g->directed ? " unbalanced=" : " odd=") + std::to_string(e.summary->odd);
+}
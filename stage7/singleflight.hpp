@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include "algo.hpp"
+
+// "ALG RANDOM k1=v1 k2=v2 ..." with the params sorted by key, so two requests
+// that differ only in parameter order map to the same string.
+inline std::string canonical_request_key(const std::string& alg, const std::string& mode, const KV& params){
+    std::vector<std::pair<std::string,std::string>> kv(params.begin(), params.end());
+    std::sort(kv.begin(), kv.end());
+    std::string key = alg + " " + mode;
+    for (auto& [k, v] : kv) { key += ' '; key += k; key += '='; key += v; }
+    return key;
+}
+
+// In-flight request coalescing. The first request for a key becomes the
+// leader and computes the answer; identical requests arriving meanwhile only
+// park their client socket on the flight. When the leader is done,
+// finish() hands back those sockets so they all get the same reply line.
+// No thread ever blocks on a flight.
+class SingleFlight {
+public:
+    // true: a flight for `key` is running and now owns `fd` (do nothing more);
+    // false: the caller is the leader and must call finish(key) on every path.
+    bool join(const std::string& key, int fd){
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = flights_.find(key);
+        if (it == flights_.end()) { flights_.emplace(key, std::vector<int>{}); return false; }
+        it->second.push_back(fd);
+        ++coalesced_;
+        return true;
+    }
+    // Ends the flight; returns the sockets of the requests that joined it.
+    std::vector<int> finish(const std::string& key){
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = flights_.find(key);
+        if (it == flights_.end()) return {};
+        std::vector<int> fds = std::move(it->second);
+        flights_.erase(it);
+        return fds;
+    }
+    unsigned long long coalesced() const { return coalesced_.load(); }
+
+private:
+    std::mutex m_;
+    std::unordered_map<std::string, std::vector<int>> flights_;
+    std::atomic<unsigned long long> coalesced_{0};
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+// ---------- per-request span tracing ----------
+// Every thread that records gets its own ring of the last kRingSize spans
+// (complete events: name, request id, start, duration). Recording takes the
+// ring's own lock, which only a dump ever contends. While tracing is off a
+// span costs one relaxed load and a predictable branch. dump() renders
+// all rings as Chrome / Perfetto JSON ("traceEvents", ph:"X").
+namespace trace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+    const char* name;      // static string
+    const char* detail;    // static string or nullptr (shown as args.alg)
+    std::uint64_t req;
+    std::int64_t ts_ns, dur_ns;
+};
+
+constexpr std::size_t kRingSize = 1u << 14;
+
+struct Ring {
+    std::mutex m;
+    std::vector<Event> ev = std::vector<Event>(kRingSize);
+    std::uint64_t head = 0;   // total events written
+    int tid = 0;
+};
+
+struct Registry {
+    std::atomic<bool> on{false};
+    std::mutex m;
+    std::vector<std::unique_ptr<Ring>> rings;   // never shrinks: threads may outlive a dump
+};
+inline Registry& registry(){ static Registry r; return r; }
+
+inline bool enabled(){ return __builtin_expect(registry().on.load(std::memory_order_relaxed), 0); }
+inline void enable(bool on){ registry().on.store(on, std::memory_order_relaxed); }
+
+inline Ring& my_ring(){
+    thread_local Ring* ring = []{
+        auto& R = registry();
+        std::lock_guard<std::mutex> lk(R.m);
+        R.rings.push_back(std::make_unique<Ring>());
+        R.rings.back()->tid = (int)R.rings.size();
+        return R.rings.back().get();
+    }();
+    return *ring;
+}
+
+inline std::int64_t ns(Clock::time_point t){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+// span with explicit bounds (e.g. queue wait: enqueue time .. dequeue time)
+inline void record(const char* name, std::uint64_t req, Clock::time_point begin, Clock::time_point end,
+                   const char* detail = nullptr){
+    if (!enabled()) return;
+    Ring& r = my_ring();
+    std::lock_guard<std::mutex> lk(r.m);
+    r.ev[r.head++ % kRingSize] = Event{name, detail, req, ns(begin), ns(end) - ns(begin)};
+}
+
+// RAII span over the enclosing scope
+class Span {
+public:
+    Span(const char* name, std::uint64_t req, const char* detail = nullptr)
+        : name_(name), detail_(detail), req_(req), on_(enabled()) { if (on_) t0_ = Clock::now(); }
+    ~Span(){ if (on_) record(name_, req_, t0_, Clock::now(), detail_); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+private:
+    const char* name_; const char* detail_;
+    std::uint64_t req_;
+    bool on_;
+    Clock::time_point t0_{};
+};
+
+inline void clear(){
+    auto& R = registry();
+    std::lock_guard<std::mutex> lk(R.m);
+    for (auto& r : R.rings) { std::lock_guard<std::mutex> rl(r->m); r->head = 0; }
+}
+
+// {"traceEvents":[...]} on one line, timestamps in microseconds
+inline std::string dump(const char* process = "server"){
+    auto& R = registry();
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char buf[320];
+    std::snprintf(buf, sizeof buf, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}", process);
+    out += buf;
+    std::lock_guard<std::mutex> lk(R.m);
+    for (auto& r : R.rings) {
+        std::lock_guard<std::mutex> rl(r->m);
+        std::uint64_t n = std::min<std::uint64_t>(r->head, kRingSize);
+        for (std::uint64_t i = r->head - n; i < r->head; ++i) {
+            const Event& e = r->ev[i % kRingSize];
+            int len = std::snprintf(buf, sizeof buf,
+                ",{\"name\":\"%s\",\"cat\":\"req\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"req\":%llu%s%s%s}}",
+                e.name, r->tid, (double)e.ts_ns / 1000.0, (double)e.dur_ns / 1000.0,
+                (unsigned long long)e.req, e.detail ? ",\"alg\":\"" : "", e.detail ? e.detail : "", e.detail ? "\"" : "");
+            out.append(buf, (std::size_t)std::min<int>(len, (int)sizeof buf - 1));
+        }
+    }
+    return out + "]}";
+}
+
+} // namespace trace
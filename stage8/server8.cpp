@@ -5,11 +5,11 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
-#include <random>
-#include <unordered_set>
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <cstdint>
+#include <memory>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -20,177 +20,439 @@
 
 #include "algo.hpp"   // from ../stage7
 #include "graph.hpp"   // from ../stage1
+#include "sched.hpp"   // from ../stage7: cost model + SEJF queue
+#include "deadline.hpp" // from ../stage7: end-to-end deadlines
+#include "singleflight.hpp" // from ../stage7: in-flight request coalescing
+#include "result_cache.hpp" // from ../stage7: LRU cache of finished replies
+#include "graph_cache.hpp"  // from ../stage7: G(n,m) generator + shared graph cache
+#include "sessions.hpp"     // from ../stage7: LOAD / RUN / DROP named graphs
+#include "derived.hpp"      // from ../stage7: derived structures shared by a BATCH
+#include "metrics.hpp"      // from ../stage7: latency histograms, Prometheus endpoint
+#include "perf_counters.hpp" // from ../stage7: perf_event counters per algorithm run
+#include "arena.hpp"        // from ../stage7: per-thread scratch pools
+#include "protocol.hpp"     // from ../stage7: socket helpers, edge payloads, session commands
 
-// ========== tiny socket helpers ==========
-static bool read_line(int fd, std::string& out){
-    out.clear(); char c; ssize_t r;
-    while (true){
-        r = recv(fd, &c, 1, 0);
-        if (r == 0) return false;
-        if (r < 0)  return false;
-        if (c == '\n') break;
-        if (c == '\r') continue;
-        out.push_back(c);
-        if (out.size() > 2'000'000) return false;
-    }
-    return true;
-}
-static bool send_line(int fd, const std::string& s){
-    size_t left = s.size(); const char* p = s.c_str();
-    while (left) { ssize_t w = send(fd, p, left, 0); if (w <= 0) return false; p += w; left -= w; }
-    return send(fd, "\n", 1, 0) == 1;
-}
-
-// ========== G(n,m) generator (same mapping as stage7) ==========
-static inline std::pair<int,int> id_to_pair_directed(std::size_t n, unsigned long long id){
-    unsigned long long row=id/(n-1), col=id%(n-1);
-    int u=(int)row, v=(int)col; if (v>=u) ++v; return {u,v};
-}
-static inline std::pair<int,int> id_to_pair_undirected(std::size_t n, unsigned long long id){
-    unsigned long long u=0, rem=id, len=n-1;
-    while (rem>=len){ rem-=len; ++u; --len; }
-    unsigned long long v=u+1+rem; return {(int)u,(int)v};
-}
-static std::vector<unsigned long long> sample_ids(unsigned long long N, unsigned long long m, std::mt19937& rng){
-    std::unordered_set<unsigned long long> S; S.reserve((size_t)m*2+16);
-    std::uniform_int_distribution<unsigned long long> dist;
-    for (unsigned long long j=N-m; j<N; ++j){
-        unsigned long long t = dist(rng, decltype(dist)::param_type(0, j));
-        if (!S.insert(t).second) S.insert(j);
-    }
-    return std::vector<unsigned long long>(S.begin(), S.end());
-}
-static void generate_Gnm(Graph& g, std::size_t target_m, unsigned seed){
-    if (g.n==0 || target_m==0) return;
-    unsigned long long N = g.directed ? (unsigned long long)g.n*(g.n-1)
-                                      : (unsigned long long)g.n*(g.n-1)/2ULL;
-    if (target_m > N) target_m = (std::size_t)N;
-    std::mt19937 rng(seed);
-    auto ids = sample_ids(N, target_m, rng);
-    for (auto id : ids){
-        auto [u,v] = g.directed ? id_to_pair_directed(g.n,id) : id_to_pair_undirected(g.n,id);
-        g.add_edge(u, v);
-    }
+// ========== request handling (same protocol as stage7) ==========
+struct Job {
+    int fd{-1};
+    std::string alg;
+    GraphRef g;          // shared, immutable (possibly cached) graph
+    std::shared_ptr<const std::vector<int>> labels;  // reorder=..: original id of each vertex of g
+    FileIds file_ids;    // FILE format=snap: the file's id of each original vertex
+    KV params;
+    double cost_us{0};
+    DeadlineClock::time_point deadline{};  // accept time + timeout_ms (none if absent)
+    std::string flight;  // set when this job leads a coalesced RANDOM flight
+    std::string cache_key;  // where a complete reply gets stored
+    std::vector<std::string> batch;  // ALG BATCH: algorithms to run on g, in order
+    DeadlineClock::time_point enqueued{};  // when it was parked in the slow lane
+};
+
+// identical RANDOM requests in flight share one computation
+static SingleFlight flights;
+// replies of finished requests, keyed by result_key()
+static ResultCache cache;
+// RANDOM graphs, shared by every algorithm run on the same (n, m, seed, directed)
+static GraphCache graphs;
+// reorder=..: relabelled copies of cached and session graphs
+static ReorderCache reorders;
+
+// latency by phase: accept->parsed, slow-lane queue, run per algorithm
+// ("run.<ALG>"), reply send
+static Metrics metrics;
+static LatencyHistogram *lat_parse, *lat_slow_wait, *lat_send;
+
+// perf_event totals per algorithm: every run with -H, else profile=1 runs
+static perf::Totals counters;
+static bool count_all = false;
+
+static bool wants_profile(const KV& params){ int pf = 0; return kv_get_int(params, "profile", pf) && pf != 0; }
+static void init_metrics(){
+    lat_parse     = &metrics.add("accept_parse");
+    lat_slow_wait = &metrics.add("slow_wait");
+    for (const char* a : {"SCC_COUNT", "HAM_CYCLE", "MAXCLIQUE", "NUM_MAXCLIQUES", "BATCH"})
+        metrics.add(std::string("run.") + a);
+    lat_send      = &metrics.add("send");
+    for (const char* a : {"SCC_COUNT", "HAM_CYCLE", "MAXCLIQUE", "NUM_MAXCLIQUES"}) counters.add(a);
 }
 
-// ========== request handling (same protocol as stage7) ==========
-static void handle_request_line(int cfd, const std::string& line){
+// named graphs uploaded once with LOAD, shared read-only by every RUN
+static SessionStore sessions;
+// the most one ALG ... GRAPH|GRAPHBIN upload may need (-U)
+static std::size_t upload_cap = std::size_t(1024) << 20;
+// FILE reads only below this directory (file_root() of -F); empty = FILE off
+static std::string files_dir;
+
+enum class Built { Error, Ready, Joined, Cached };
+
+// Parse the request line (and GRAPH edge lines) into a Job. Error: the reply
+// has already been sent. Joined: an identical request is in flight and now
+// owns cfd. Cached: the stored reply has been sent.
+static Built build_job(int cfd, const std::string& line, DeadlineClock::time_point accepted, Job& out){
     // Syntax:
     // ALG <NAME> RANDOM n=.. m=.. seed=.. directed=0|1 [limit=..] [timeout_ms=..] [step_limit=..]
     // ALG <NAME> GRAPH  n=.. directed=0|1 m=.. [limit=..] [timeout_ms=..] [step_limit=..]  + m lines "u v"
-    std::vector<std::string> tok; tok.reserve(16);
-    { std::string cur; for(char ch: line){ if(ch==' '||ch=='\t'){ if(!cur.empty()){ tok.push_back(cur); cur.clear(); } } else cur.push_back(ch); } if(!cur.empty()) tok.push_back(cur); }
+    // ALG <NAME> GRAPHBIN (same keys)  + m pairs of native int32
+    // ALG <NAME> FILE path=<file> [verify=0] [format=..] [limit=..] [timeout_ms=..] [step_limit=..]
+    // RUN <NAME> <session> [limit=..] [timeout_ms=..] [step_limit=..]
+    // where <NAME> may be "BATCH <A1,A2,...>"; any form takes [reorder=degree|bfs|rcm]
+    auto tok = split_ws(line);
 
-    if (tok.size() < 3 || tok[0] != "ALG"){ send_line(cfd, "ERR expected 'ALG <NAME> <MODE>'"); return; }
+    if (tok.size() < 3 || (tok[0] != "ALG" && tok[0] != "RUN")){ send_line(cfd, "ERR expected 'ALG <NAME> <MODE>' or 'RUN <NAME> <graph>'"); return Built::Error; }
+    if (tok[1] == "BATCH") {
+        if (tok.size() < 4) { send_line(cfd, "ERR expected 'BATCH <A1,A2,...> <MODE>'"); return Built::Error; }
+        std::string a;
+        for (std::size_t i=0; i<=tok[2].size(); ++i) {
+            if (i<tok[2].size() && tok[2][i]!=',') { a.push_back(tok[2][i]); continue; }
+            if (!std::unique_ptr<IAlgorithm>(make_algorithm(a))) { send_line(cfd, "ERR unknown algorithm " + a); return Built::Error; }
+            out.batch.push_back(a); a.clear();
+        }
+        tok.erase(tok.begin()+2);
+    }
+    const bool batch = !out.batch.empty();
     std::string alg = tok[1], mode = tok[2];
     KV params = kv_from_tokens(std::vector<std::string>(tok.begin()+3, tok.end()));
 
     std::size_t n=0, m=0; unsigned seed=0; int directed=0;
+    Reorder order = Reorder::None;   // checked before a RANDOM flight is opened
+    if (auto it = params.find("reorder"); it != params.end() && !parse_reorder(it->second, order)) {
+        send_line(cfd, "ERR reorder must be none, degree, bfs or rcm");
+        return Built::Error;
+    }
 
-    if (mode == "RANDOM"){
-        if (!kv_get_size_t(params, "n", n)) { send_line(cfd, "ERR missing n"); return; }
-        if (!kv_get_size_t(params, "m", m)) { send_line(cfd, "ERR missing m"); return; }
+    if (tok[0] == "RUN"){
+        auto s = sessions.find(mode);
+        if (!s.g) { send_line(cfd, "ERR no such graph"); return Built::Error; }
+        if (std::string known; !batch && answer_from_summary(alg, s, known)) { send_line(cfd, known); return Built::Cached; }
+        if (!batch) out.cache_key = result_key(alg, "SESSION", params, "s=" + std::to_string(s.id));
+        if (std::string hit; !batch && cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+        out.g = std::move(s.g);
+        n = out.g->n;
+    }
+    else if (mode == "RANDOM"){
+        if (!kv_get_size_t(params, "n", n)) { send_line(cfd, "ERR missing n"); return Built::Error; }
+        if (!kv_get_size_t(params, "m", m)) { send_line(cfd, "ERR missing m"); return Built::Error; }
         kv_get_uint(params, "seed",   seed);
         kv_get_int (params, "directed", directed);
 
-        Graph g(n, directed!=0);
-        generate_Gnm(g, m, seed);
+        if (!batch) {
+            out.cache_key = result_key(alg, mode, params);
+            if (std::string hit; cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+            std::string key = canonical_request_key(alg, mode, params);
+            if (flights.join(key, cfd)) return Built::Joined;
+            out.flight = std::move(key);
+        }
 
-        std::unique_ptr<IAlgorithm> A(make_algorithm(alg));
-        if (!A) { send_line(cfd, "ERR unknown algorithm"); return; }
-        auto res = A->run(g, params);
-        send_line(cfd, std::string("OK ")+alg+" "+res.text);
-        return;
+        out.g = graphs.get(n, m, seed, directed!=0);
     }
-    else if (mode == "GRAPH"){
-        if (!kv_get_size_t(params, "n", n)) { send_line(cfd, "ERR missing n"); return; }
-        if (!kv_get_size_t(params, "m", m)) { send_line(cfd, "ERR missing m"); return; }
-        kv_get_int(params, "directed", directed);
-
-        Graph g(n, directed!=0);
-        for (std::size_t i=0;i<m;++i){
-            std::string el; if (!read_line(cfd, el)) { send_line(cfd, "ERR premature end while reading edges"); return; }
-            int u=-1, v=-1; if (std::sscanf(el.c_str(), "%d %d", &u, &v) != 2) { send_line(cfd, "ERR bad edge format"); return; }
-            g.add_edge(u, v);
-        }
-        std::unique_ptr<IAlgorithm> A(make_algorithm(alg));
-        if (!A) { send_line(cfd, "ERR unknown algorithm"); return; }
-        auto res = A->run(g, params);
-        send_line(cfd, std::string("OK ")+alg+" "+res.text);
-        return;
+    else if (mode == "GRAPH" || mode == "GRAPHBIN"){
+        EdgeHash eh;
+        if (!read_edges(cfd, mode, params, upload_cap, out.g, eh)) return Built::Error;
+        n = out.g->n;
+        if (!batch) out.cache_key = result_key(alg, "GRAPH", params, eh.str());
+        if (std::string hit; !batch && cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+    }
+    else if (mode == "FILE"){
+        std::string version;
+        if (!(out.g = file_graph(cfd, params, graphs, files_dir, version, &out.file_ids))) return Built::Error;
+        n = out.g->n;
+        if (!batch) out.cache_key = result_key(alg, mode, params, version);
+        if (std::string hit; !batch && cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
     }
     else {
-        send_line(cfd, "ERR mode must be RANDOM or GRAPH");
-        return;
+        send_line(cfd, "ERR mode must be RANDOM, GRAPH, GRAPHBIN or FILE");
+        return Built::Error;
     }
+    if (order != Reorder::None) {
+        // request-owned GRAPH uploads are permuted directly, shared graphs once per ordering
+        auto p = mode == "GRAPH" || mode == "GRAPHBIN" ? reorder_graph(*out.g, order) : reorders.get(out.g, order);
+        out.g = GraphRef(p, &p->g);
+        out.labels = std::shared_ptr<const std::vector<int>>(p, &p->to_old);
+    }
+    out.fd = cfd;
+    out.alg = alg;
+    out.cost_us = 0;
+    for (auto& a : batch ? out.batch : std::vector<std::string>{alg}) out.cost_us += estimate_cost_us(a, n, out.g->m, params);
+    out.deadline = deadline_from(params, accepted);
+    out.params = std::move(params);
+    return Built::Ready;
 }
 
-// ========== Leader–Follower thread pool ==========
+// Send the reply to the job's client and to every request that joined its
+// flight, closing all of them. Complete answers are cached on the way out.
+static void reply(Job& j, const std::string& text){
+    if (!j.cache_key.empty() && cacheable_reply(text)) cache.put(j.cache_key, text);
+    auto t0 = DeadlineClock::now();
+    send_line(j.fd, text); close(j.fd);
+    if (!j.flight.empty())
+        for (int fd : flights.finish(j.flight)) { send_line(fd, text); close(fd); }
+    lat_send->record(DeadlineClock::now() - t0);
+}
+
+// BATCH: one thread runs the algorithms in turn over one set of derived
+// structures, each with whatever is left of the shared deadline.
+static void run_batch(Job& j){
+    auto t0 = DeadlineClock::now();
+    LabelScope ids(j.labels.get(), j.file_ids.get());
+    DerivedGraph d(j.g);
+    std::string all = "OK BATCH count=" + std::to_string(j.batch.size());
+    for (auto& a : j.batch) {
+        KV params = j.params;
+        all += '\n';
+        if (!apply_remaining(params, j.deadline)) { all += "ERR DEADLINE"; continue; }
+        bool profile = wants_profile(params);
+        perf::Scope pc(profile || count_all);
+        all += "OK " + a + " " + run_with_derived(a, d, params).text;
+        auto counted = pc.stop();
+        counters.record(a, counted);
+        if (profile) all += perf::reply_suffix(counted);
+    }
+    metrics.find("run.BATCH")->record(DeadlineClock::now() - t0);
+    reply(j, all);
+    arena::trim_scratch();
+}
+
+static void run_job(Job& j){
+    if (!j.batch.empty()) { run_batch(j); return; }
+    std::unique_ptr<IAlgorithm> A(make_algorithm(j.alg));
+    if (!A) { reply(j, "ERR unknown algorithm"); return; }
+    // a job parked in the slow lane may have run out of time already
+    if (!apply_remaining(j.params, j.deadline)) { reply(j, "ERR DEADLINE"); return; }
+    auto t0 = DeadlineClock::now();
+    bool profile = wants_profile(j.params);
+    LabelScope ids(j.labels.get(), j.file_ids.get());
+    perf::Scope pc(profile || count_all);
+    auto res = A->run(*j.g, j.params);
+    auto counted = pc.stop();
+    if (auto* h = metrics.find("run." + j.alg)) h->record(DeadlineClock::now() - t0);
+    counters.record(j.alg, counted);
+    reply(j, std::string("OK ")+j.alg+" "+res.text + (profile ? perf::reply_suffix(counted) : ""));
+    arena::trim_scratch();
+}
+
+// ========== cost-based scheduling ==========
+// Cheap jobs (estimate below kFastLaneUs) run right away on the thread that
+// accepted them. Expensive ones need one of `slots` (threads-1) slow slots;
+// when none is free the job is parked in a SEJF queue and the thread goes
+// back to the LF pool. A thread that finishes an expensive job keeps its slot
+// and serves the queue before it rejoins, so at least one thread is always
+// left to accept and to run cheap requests. With one thread there is no slow
+// lane. Once the server stops, parked jobs are answered "ERR SHUTDOWN".
 static std::atomic<bool> running(true);
+
+struct SlowLane {
+    std::mutex m;
+    bool enabled = true;
+    int slots = 1, running = 0;
+    SejfQueue<Job> q;
+};
+
+static void serve(SlowLane* sl, Job&& job){
+    if (!sl->enabled || job.cost_us < kFastLaneUs) { run_job(job); return; }
+    {
+        std::lock_guard<std::mutex> lk(sl->m);
+        if (sl->running >= sl->slots) {
+            double c = job.cost_us; job.enqueued = DeadlineClock::now();
+            sl->q.push(std::move(job), c); return;
+        }
+        ++sl->running;
+    }
+    while (true) {
+        run_job(job);
+        std::lock_guard<std::mutex> lk(sl->m);
+        if (sl->q.empty() || !running.load()) { --sl->running; return; }
+        job = sl->q.pop();
+        lat_slow_wait->record(DeadlineClock::now() - job.enqueued);
+    }
+}
+
+static void drain(SlowLane* sl){
+    std::lock_guard<std::mutex> lk(sl->m);
+    while (!sl->q.empty()) { Job j = sl->q.pop(); reply(j, "ERR SHUTDOWN"); }
+}
+
+// "OK STATS slow.depth=.. slow.running=.. ... lat.<phase>.p50_us=.." (one line)
+static std::string stats_line(SlowLane* sl){
+    std::size_t depth; int running_now;
+    { std::lock_guard<std::mutex> lk(sl->m); depth = sl->q.size(); running_now = sl->running; }
+    return "OK STATS slow.depth=" + std::to_string(depth) + " slow.running=" + std::to_string(running_now)
+         + " slow.slots=" + std::to_string(sl->slots) + " coalesced=" + std::to_string(flights.coalesced())
+         + metrics.text() + counters.text();
+}
+static std::string stats_json(SlowLane* sl){
+    std::size_t depth; int running_now;
+    { std::lock_guard<std::mutex> lk(sl->m); depth = sl->q.size(); running_now = sl->running; }
+    return "{\"slow\":{\"depth\":" + std::to_string(depth) + ",\"running\":" + std::to_string(running_now)
+         + ",\"slots\":" + std::to_string(sl->slots) + "},\"coalesced\":" + std::to_string(flights.coalesced())
+         + ",\"latency\":" + metrics.json() + ",\"perf\":" + counters.json() + "}";
+}
+static std::string prometheus_text(SlowLane* sl){
+    std::size_t depth;
+    { std::lock_guard<std::mutex> lk(sl->m); depth = sl->q.size(); }
+    return metrics.prometheus("server8") + "# TYPE server8_queue_depth gauge\nserver8_queue_depth{queue=\"slow\"} "
+         + std::to_string(depth) + "\n";
+}
+
+// result cache counters followed by the graph cache's
+static std::string cache_stats_line(){
+    auto g = graphs.stats();
+    return cache.stats_line() + " graphs.hits=" + std::to_string(g.hits) + " graphs.misses=" + std::to_string(g.misses)
+         + " graphs.entries=" + std::to_string(g.entries) + " graphs.bytes=" + std::to_string(g.bytes)
+         + " graphs.capacity=" + std::to_string(g.capacity);
+}
+
+static void handle_request_line(SlowLane* sl, int cfd, const std::string& line,
+                                DeadlineClock::time_point accepted){
+    if (line == "STATS") { send_line(cfd, stats_line(sl)); close(cfd); return; }
+    if (line == "STATS JSON") { send_line(cfd, stats_json(sl)); close(cfd); return; }
+    if (session_command(cfd, line, sessions, graphs, files_dir)) { close(cfd); return; }
+    if (line == "CACHE STATS") { send_line(cfd, cache_stats_line()); close(cfd); return; }
+    if (line == "CACHE CLEAR") { cache.clear(); graphs.clear(); reorders.clear(); send_line(cfd, "OK CACHE CLEARED"); close(cfd); return; }
+    Job job;
+    switch (build_job(cfd, line, accepted, job)) {
+        case Built::Error:
+        case Built::Cached: close(cfd); return;
+        case Built::Joined: return;              // the flight leader replies
+        case Built::Ready:  break;
+    }
+    lat_parse->record(DeadlineClock::now() - accepted);
+    serve(sl, std::move(job));   // closes cfd (now or once the queued job ran)
+}
+
+// ========== Leader–Follower thread pool ==========
 static int listen_fd = -1;
 
+// Followers park on their own condition variable, so promotion wakes exactly
+// one thread. Only idle threads sit on the stack, so a busy worker can never be
+// named leader; if nobody is idle the role stays vacant and the next worker to
+// finish its request takes it directly. LIFO keeps the most recently active
+// (cache-warm) thread in front.
 struct LF {
+    struct Slot {
+        std::condition_variable cv;
+        bool promoted = false;
+    };
     std::mutex m;
-    std::condition_variable cv;
-    int leader_id = -1;         // which worker is the leader
-    int threads   = 0;
+    bool has_leader = false;
+    std::vector<int> idle;      // stack of parked follower ids
+    std::vector<Slot> slots;    // one per worker
+    explicit LF(int threads) : slots(threads) { idle.reserve(threads); }
 };
 
-static void worker_loop(LF* lf, int id){
+// Called by the leader (with lf->m held) to hand the role over.
+static void promote_next(LF* lf){
+    if (lf->idle.empty()) { lf->has_leader = false; return; }
+    int next = lf->idle.back(); lf->idle.pop_back();
+    lf->slots[next].promoted = true;
+    lf->slots[next].cv.notify_one();
+}
+
+static void wake_all(LF* lf){
+    std::lock_guard<std::mutex> lk(lf->m);
+    for (auto& s : lf->slots) s.cv.notify_one();
+}
+
+static void worker_loop(LF* lf, SlowLane* sl, int id){
+    auto& me = lf->slots[id];
     while (running.load(std::memory_order_relaxed)) {
-        // become leader
+        // become leader: take a vacant role, otherwise park until promoted
         {
             std::unique_lock<std::mutex> lk(lf->m);
-            if (lf->leader_id == -1) lf->leader_id = id;
-            lf->cv.wait(lk, [&]{ return !running.load() || lf->leader_id == id; });
-            if (!running.load()) return;
+            if (!lf->has_leader) {
+                lf->has_leader = true;
+            } else {
+                lf->idle.push_back(id);
+                me.cv.wait(lk, [&]{ return !running.load() || me.promoted; });
+                if (!me.promoted) return;   // shutting down
+                me.promoted = false;
+            }
         }
 
         // leader blocks in accept()
         sockaddr_in cli{}; socklen_t cl = sizeof(cli);
         int cfd = accept(listen_fd, (sockaddr*)&cli, &cl);
         if (cfd < 0) {
-            if (!running.load()) return;
-            // transient error (EINTR/EAGAIN/etc). yield leader role to another and retry
-            std::unique_lock<std::mutex> lk(lf->m);
-            lf->leader_id = (id + 1) % lf->threads;
-            lf->cv.notify_all();
-            lk.unlock();
+            if (!running.load()) { wake_all(lf); return; }
+            // transient error (EINTR/ECONNABORTED/etc): release the role and
+            // retry; the loop head takes it back unless a finishing worker did
             std::this_thread::yield();
+            std::lock_guard<std::mutex> lk(lf->m);
+            lf->has_leader = false;
             continue;
         }
 
-        // promote a follower to leader BEFORE handling the client
+        auto accepted = DeadlineClock::now();
+
+        // promote one idle follower BEFORE handling the client
         {
-            std::unique_lock<std::mutex> lk(lf->m);
-            lf->leader_id = (id + 1) % lf->threads;
-            lf->cv.notify_all();
+            std::lock_guard<std::mutex> lk(lf->m);
+            promote_next(lf);
         }
 
         // Handle client (single request per connection)
         std::string line;
-        if (read_line(cfd, line)) {
-            handle_request_line(cfd, line);
-        }
-        close(cfd);
-        // loop back; this worker will become leader again in turn
+        if (read_line(cfd, line)) handle_request_line(sl, cfd, line, accepted);
+        else close(cfd);
+        // loop back: lead again if the role is vacant, else join the idle stack
     }
 }
 
 static void usage(const char* p){
-    std::cerr << "Usage: " << p << " -p <port> [-t <threads>]\n";
+    std::cerr << "Usage: " << p << " -p <port> [-t <threads>] [-S sejf|fifo] [-C <cache MiB>] [-G <graph cache MiB>]\n"
+              << "          [-M <session quota MiB>] [-U <upload MiB>] [-F <dir>] [-P <metrics port>] [-H] [-A]\n"
+              << "  -S  sejf: expensive requests share threads-1 slots in shortest-expected-job-first\n"
+              << "      order (with aging); fifo: every thread runs what it accepts (default: sejf,\n"
+              << "      fifo with -t 1)\n"
+              << "  -C  result cache size in MiB, 0 = off (default: 64); 'CACHE STATS' / 'CACHE CLEAR'\n"
+              << "  -G  generated-graph cache size in MiB, 0 = off (default: 128)\n"
+              << "  -M  memory for graphs stored with 'LOAD <name> GRAPH|GRAPHBIN|RANDOM|FILE ...' and run\n"
+              << "      with 'RUN <ALG> <name> [params]' until 'DROP <name>' (default: 256);\n"
+              << "      'ADD_EDGES|REMOVE_EDGES <name> m=<k>' + k \"u v\" lines make a new version;\n"
+              << "      also caps the memory one LOAD GRAPH/GRAPHBIN upload (from n and m in its header) may need\n"
+              << "  -U  memory one 'ALG ... GRAPH|GRAPHBIN' upload (from n and m in its header) may need,\n"
+              << "      larger ones get ERR QUOTA before anything is read (default: 1024)\n"
+              << "  -F  directory that 'FILE path=..' may read from, relative paths start there\n"
+              << "      (default: none, FILE is refused)\n"
+              << "  -P  serve Prometheus metrics on 127.0.0.1:<port> (default: off); 'STATS' / 'STATS JSON'\n"
+              << "      on the main port report the same latency histograms\n"
+              << "  -H  count cycles/instructions/cache and branch misses (perf_event_open) for every\n"
+              << "      algorithm run, totals in 'STATS'; a single request can ask with profile=1\n"
+              << "  -A  plain malloc for algorithm temporaries (default: per-thread scratch pools)\n";
 }
 
-static void sigint_handler(int){ running.store(false); if (listen_fd>=0) close(listen_fd); }
+// shutdown() wakes a leader blocked in accept(); close() alone does not.
+static void sigint_handler(int){ running.store(false); if (listen_fd>=0) { shutdown(listen_fd, SHUT_RDWR); close(listen_fd); } }
 
 int main(int argc, char** argv){
     int port = 5558;
     int nthreads = std::max(2, (int)std::thread::hardware_concurrency()); // default
+    std::string sched = "sejf";
+    long cache_mb = 64, graph_mb = 128, session_mb = 256, upload_mb = 1024;
+    std::string file_dir;
+    int metrics_port = 0;
     for (int i=1;i<argc;++i){
         if (std::string(argv[i])=="-p" && i+1<argc) port = std::atoi(argv[++i]);
         else if (std::string(argv[i])=="-t" && i+1<argc) nthreads = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i])=="-S" && i+1<argc) sched = argv[++i];
+        else if (std::string(argv[i])=="-C" && i+1<argc) cache_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-G" && i+1<argc) graph_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-M" && i+1<argc) session_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-U" && i+1<argc) upload_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-F" && i+1<argc) file_dir = argv[++i];
+        else if (std::string(argv[i])=="-P" && i+1<argc) metrics_port = std::atoi(argv[++i]);
+        else if (std::string(argv[i])=="-H") count_all = true;
+        else if (std::string(argv[i])=="-A") arena::enable(false);
         else { usage(argv[0]); return 2; }
     }
+    if (sched != "sejf" && sched != "fifo") { usage(argv[0]); return 2; }
+    cache.resize((std::size_t)cache_mb << 20);
+    graphs.resize((std::size_t)graph_mb << 20);
+    sessions.set_quota((std::size_t)session_mb << 20);
+    upload_cap = (std::size_t)upload_mb << 20;
+    if (!file_dir.empty() && (files_dir = file_root(file_dir)).empty()) {
+        std::cerr << "-F: no such directory " << file_dir << "\n";
+        return 2;
+    }
 
     signal(SIGINT, sigint_handler);
 
@@ -203,13 +465,21 @@ int main(int argc, char** argv){
     if (listen(listen_fd, 128) < 0) { perror("listen"); return 1; }
 
     std::cout << "Stage8 Leader–Follower server on port " << port
-              << " with " << nthreads << " threads. Ctrl+C to stop.\n";
+              << " with " << nthreads << " threads (" << sched << "). Ctrl+C to stop.\n";
+
+    SlowLane sl;
+    sl.enabled = sched == "sejf" && nthreads > 1;
+    sl.slots = sl.enabled ? nthreads - 1 : 0;
+    init_metrics();
+    if (metrics_port > 0 && !serve_prometheus(metrics_port, [&sl]{ return prometheus_text(&sl); }))
+        std::cerr << "metrics: cannot listen on 127.0.0.1:" << metrics_port << "\n";
 
-    LF lf; lf.threads = nthreads;
+    LF lf(nthreads);
     std::vector<std::thread> pool;
     pool.reserve(nthreads);
-    for (int i=0;i<nthreads;++i) pool.emplace_back(worker_loop, &lf, i);
+    for (int i=0;i<nthreads;++i) pool.emplace_back(worker_loop, &lf, &sl, i);
 
     for (auto& th : pool) th.join();
+    drain(&sl);
     return 0;
 }
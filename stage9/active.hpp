@@ -6,14 +6,150 @@
 #include <atomic>
 #include <utility>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AO_CPU_RELAX() _mm_pause()
+#else
+#define AO_CPU_RELAX() std::this_thread::yield()
+#endif
+
+// Vyukov's intrusive multi-producer / single-consumer queue. push() is one
+// atomic exchange plus one store; pop() touches no shared counter. The value
+// lives inside the node, and the consumer keeps the last popped node as the
+// new stub, so T must be default-constructible.
 template <typename T>
-class ActiveObject {
+class MpscQueue {
 public:
-    using Handler = void(*)(T&&, void*);
+    MpscQueue() : head_(new Node), tail_(head_.load(std::memory_order_relaxed)) {}
+    ~MpscQueue(){ T tmp; while (pop(tmp)) {} delete tail_; }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
 
+    void push(T v) {
+        Node* n = new Node;
+        n->value = std::move(v);
+        Node* prev = head_.exchange(n, std::memory_order_seq_cst);
+        prev->next.store(n, std::memory_order_release);
+    }
+    // consumer only; false if empty (or a producer is between its two steps)
+    bool pop(T& out) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+    // consumer only; also sees items whose link is not published yet
+    bool empty() const { return head_.load(std::memory_order_seq_cst) == tail_; }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+    alignas(64) std::atomic<Node*> head_;   // producers
+    alignas(64) Node* tail_;                // consumer
+};
+
+// Wraps a free function as a stateless callable type, so the handler call
+// compiles to a direct (inlinable) call: ActiveObject<Req, Call<&handle>>.
+template <auto Fn>
+struct Call {
+    template <typename U>
+    void operator()(U&& item, void* ctx) const { Fn(std::forward<U>(item), ctx); }
+};
+
+// One consumer thread draining an MpscQueue. The consumer handles everything
+// available in one go, spins a little (adaptively) when the queue runs dry and
+// then parks. Only the producer that finds the consumer parked pays for the
+// mutex + notify, so a burst of posts costs one wakeup.
+template <typename T, typename Handler = void(*)(T&&, void*)>
+class ActiveObject {
+public:
     ActiveObject() = default;
     ~ActiveObject(){ stop(); }
 
+    void start(Handler h, void* ctx, const char* name = nullptr) {
+        handler_ = h; ctx_ = ctx; running_.store(true);
+        thr_ = std::thread([this,name]{ loop(name); });
+    }
+    void post(T item) {
+        depth_.fetch_add(1, std::memory_order_relaxed);
+        q_.push(std::move(item));
+        if (parked_.load(std::memory_order_seq_cst) && parked_.exchange(false)) {
+            std::lock_guard<std::mutex> lk(m_);
+            cv_.notify_one();
+        }
+    }
+    void stop() {
+        bool expected = true;
+        if (running_.compare_exchange_strong(expected, false)) {
+            { std::lock_guard<std::mutex> lk(m_); cv_.notify_all(); }
+            if (thr_.joinable()) thr_.join();
+        }
+    }
+    // items posted but not yet handled (approximate while producers race)
+    std::size_t depth() const { return depth_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int kSpinMin = 16, kSpinMax = 4096;
+
+    // handle everything currently visible; returns how many items ran
+    std::size_t drain() {
+        std::size_t n = 0;
+        T item;
+        while (q_.pop(item)) {
+            depth_.fetch_sub(1, std::memory_order_relaxed);
+            handler_(std::move(item), ctx_); ++n;
+        }
+        return n;
+    }
+
+    void loop(const char* /*name*/) {
+        int spin = kSpinMin;
+        while (running_.load(std::memory_order_relaxed)) {
+            if (drain()) continue;
+            // spin-then-park; grow the spin budget when spinning pays off
+            bool got = false;
+            for (int i = 0; i < spin; ++i) {
+                if (!q_.empty()) { got = true; break; }
+                AO_CPU_RELAX();
+            }
+            if (got) { spin = std::min(spin * 2, kSpinMax); continue; }
+            spin = std::max(spin / 2, kSpinMin);
+
+            std::unique_lock<std::mutex> lk(m_);
+            parked_.store(true, std::memory_order_seq_cst);
+            cv_.wait(lk, [&]{ return !running_.load() || !q_.empty(); });
+            parked_.store(false, std::memory_order_relaxed);
+        }
+        // drain remaining items (producers may still be finishing a push)
+        while (!q_.empty()) if (!drain()) std::this_thread::yield();
+    }
+
+    MpscQueue<T> q_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::atomic<bool> parked_{false};
+    std::atomic<std::size_t> depth_{0};
+    std::thread thr_;
+    std::atomic<bool> running_{false};
+    Handler handler_{};
+    void* ctx_{nullptr};
+};
+
+// The original mutex + deque ActiveObject (one item per lock acquisition).
+// Kept as the baseline for stage12/bench_active.
+template <typename T>
+class LockedActiveObject {
+public:
+    using Handler = void(*)(T&&, void*);
+
+    LockedActiveObject() = default;
+    ~LockedActiveObject(){ stop(); }
+
     void start(Handler h, void* ctx, const char* name = nullptr) {
         handler_ = h; ctx_ = ctx; running_.store(true);
         thr_ = std::thread([this,name]{ loop(name); });
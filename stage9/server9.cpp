@@ -2,13 +2,12 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
 #include <algorithm>
-#include <random>
 #include <memory>
 #include <csignal>
 #include <cstring>
 #include <cstdlib>
+#include <cstdint>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -17,72 +16,60 @@
 #include <unistd.h>
 
 #include "active.hpp"
+#include "steal_pool.hpp"
+#include "sched.hpp"      // Stage 7: estimate_cost_us
+#include "deadline.hpp"   // Stage 7: end-to-end deadlines
+#include "singleflight.hpp" // Stage 7: in-flight request coalescing
+#include "result_cache.hpp" // Stage 7: LRU cache of finished replies
+#include "graph_cache.hpp"  // Stage 7: G(n,m) generator + shared graph cache
+#include "sessions.hpp"     // Stage 7: LOAD / RUN / DROP named graphs
+#include "derived.hpp"      // Stage 7: derived structures shared by a BATCH
+#include "metrics.hpp"      // Stage 7: latency histograms, Prometheus endpoint
+#include "trace.hpp"        // Stage 7: per-request spans, Chrome trace export
+#include "perf_counters.hpp" // Stage 7: perf_event counters per algorithm run
+#include "arena.hpp"         // Stage 7: per-thread scratch pools
+#include "protocol.hpp"      // Stage 7: socket helpers, edge payloads, session commands
 #include "algo.hpp"      // Stage 7: IAlgorithm, make_algorithm, KV helpers
 #include "graph.hpp"      // Stage 1
 
-// -------- socket helpers --------
-static bool read_line(int fd, std::string& out){
-    out.clear(); char c; ssize_t r;
-    while (true){
-        r = recv(fd, &c, 1, 0);
-        if (r == 0) return false;
-        if (r < 0)  return false;
-        if (c == '\n') break;
-        if (c == '\r') continue;
-        out.push_back(c);
-        if (out.size() > 2'000'000) return false;
-    }
-    return true;
-}
-static bool send_line(int fd, const std::string& s){
-    size_t left=s.size(); const char* p=s.c_str();
-    while(left){ ssize_t w=send(fd,p,left,0); if(w<=0) return false; p+=w; left-=w; }
-    return send(fd, "\n", 1, 0) == 1;
-}
-
-// -------- exact G(n,m) generator (Robert Floyd) --------
-static inline std::pair<int,int> id_to_pair_directed(std::size_t n, unsigned long long id){
-    unsigned long long row=id/(n-1), col=id%(n-1);
-    int u=(int)row, v=(int)col; if (v>=u) ++v; return {u,v};
-}
-static inline std::pair<int,int> id_to_pair_undirected(std::size_t n, unsigned long long id){
-    unsigned long long u=0, rem=id, len=n-1;
-    while(rem>=len){ rem-=len; ++u; --len; }
-    unsigned long long v=u+1+rem; return {(int)u,(int)v};
-}
-static std::vector<unsigned long long> sample_ids(unsigned long long N, unsigned long long m, std::mt19937& rng){
-    std::unordered_set<unsigned long long> S; S.reserve((size_t)m*2+16);
-    std::uniform_int_distribution<unsigned long long> dist;
-    for (unsigned long long j=N-m; j<N; ++j){
-        unsigned long long t=dist(rng, decltype(dist)::param_type(0,j));
-        if(!S.insert(t).second) S.insert(j);
-    }
-    return std::vector<unsigned long long>(S.begin(), S.end());
-}
-static void generate_Gnm(Graph& g, std::size_t target_m, unsigned seed){
-    if (g.n==0 || target_m==0) return;
-    unsigned long long N = g.directed ? (unsigned long long)g.n*(g.n-1)
-                                      : (unsigned long long)g.n*(g.n-1)/2ULL;
-    if (target_m > N) target_m = (std::size_t)N;
-    std::mt19937 rng(seed);
-    auto ids = sample_ids(N, target_m, rng);
-    for (auto id : ids){
-        auto [u,v] = g.directed ? id_to_pair_directed(g.n,id) : id_to_pair_undirected(g.n,id);
-        g.add_edge(u, v);
-    }
-}
-
 // -------- jobs through the pipeline --------
+struct Batch;
+
 struct Request {
     int client_fd{-1};
     std::string alg;     // "SCC_COUNT" | "HAM_CYCLE" | ...
-    Graph g{0,false};
+    GraphRef g;          // shared, immutable (possibly cached) graph
+    std::shared_ptr<const std::vector<int>> labels;  // reorder=..: original id of each vertex of g
+    FileIds file_ids;    // FILE format=snap: the file's id of each original vertex
     KV params;           // includes directed/seed/timeout_ms/etc
+    double cost_us{0};   // estimate_cost_us(), orders the stage queue
+    DeadlineClock::time_point deadline{};  // accept time + timeout_ms (none if absent)
+    std::string flight;  // set when this request leads a coalesced RANDOM flight
+    std::string cache_key;  // where a complete reply gets stored
+    std::shared_ptr<Batch> batch;  // ALG BATCH: the shared fan-out state
+    int slot{-1};                  // this request's line in the batch (-1: not fanned out yet)
+    std::vector<StageSlot> admitted;  // stage queue places from admission, one per algorithm
+    DeadlineClock::time_point enqueued{};  // when it entered its current queue
+    std::uint64_t id{0};                   // request id, tags its trace spans
+};
+
+// One ALG BATCH request: the dispatcher posts one Request per algorithm to the
+// stages, all sharing the graph and its derived structures; the stage that
+// fills the last line hands the whole multi-line reply to the responder.
+struct Batch {
+    std::vector<std::string> algs;
+    std::vector<std::string> lines;
+    std::atomic<int> remaining{0};
+    std::shared_ptr<DerivedGraph> derived;
 };
 
 struct Response {
     int client_fd{-1};
     std::string text;    // final line to send (e.g., "OK ...")
+    std::string flight;  // the responder also answers everyone who joined it
+    std::string cache_key;
+    DeadlineClock::time_point enqueued{};
+    std::uint64_t id{0};
 };
 
 // Forward declarations of handlers
@@ -93,26 +80,107 @@ static void ham_handle   (Request&& r, void* ctx);
 static void maxclq_handle(Request&& r, void* ctx);
 static void numclq_handle(Request&& r, void* ctx);
 static void respond_handle(Response&& resp, void* ctx);
+static void busy_handle  (Request&& r, void* ctx);
 
 // -------- pipeline object holding all active objects --------
 struct Pipeline {
-    // 1 dispatcher, 4 algo workers, 1 responder
-    ActiveObject<Request> dispatcher;
-    ActiveObject<Request> scc_ao, ham_ao, maxclq_ao, numclq_ao;
-    ActiveObject<Response> responder;
+    // 1 dispatcher, 4 algorithm stages on a shared work-stealing pool, 1 responder
+    ActiveObject<Request, Call<&dispatch_handle>> dispatcher;
+    WorkStealingPool pool;
+    StageExecutor<Request> scc_ao, ham_ao, maxclq_ao, numclq_ao;
+    ActiveObject<Response, Call<&respond_handle>> responder;
+    std::atomic<unsigned long long> deadline_dropped{0};
+    SingleFlight flights;   // identical RANDOM requests share one computation
+    ResultCache cache;      // replies of finished requests, keyed by result_key()
+    GraphCache graphs;      // RANDOM graphs shared across algorithms
+    ReorderCache reorders;  // reorder=..: relabelled copies of cached and session graphs
+    SessionStore sessions;  // graphs uploaded once with LOAD, run with RUN
+    std::size_t upload_cap = std::size_t(1024) << 20;   // the most one ALG ... GRAPH|GRAPHBIN upload may need (-U)
+    std::string files_dir;  // FILE reads only below this directory (file_root() of -F); empty = FILE off
+
+    // latency by phase: accept->parsed, dispatcher queue, per-algorithm stage
+    // queue ("queue.<ALG>") and run ("run.<ALG>"), responder queue, send
+    Metrics metrics;
+    LatencyHistogram *lat_parse{}, *lat_dispatch{}, *lat_respond{}, *lat_send{};
+    // perf_event totals per algorithm: every run with -H, else profile=1 runs
+    perf::Totals counters;
+    bool count_all = false;
+    void init_metrics(){
+        lat_parse    = &metrics.add("accept_parse");
+        lat_dispatch = &metrics.add("dispatch_wait");
+        for (const char* a : {"SCC_COUNT", "HAM_CYCLE", "MAXCLIQUE", "NUM_MAXCLIQUES"}) {
+            metrics.add(std::string("queue.") + a);
+            metrics.add(std::string("run.") + a);
+            counters.add(a);
+        }
+        lat_respond  = &metrics.add("respond_wait");
+        lat_send     = &metrics.add("send");
+    }
+
+    StageExecutor<Request>* stage_for(const std::string& alg){
+        if (alg == "SCC_COUNT")      return &scc_ao;
+        if (alg == "HAM_CYCLE")      return &ham_ao;
+        if (alg == "MAXCLIQUE")      return &maxclq_ao;
+        if (alg == "NUM_MAXCLIQUES") return &numclq_ao;
+        return nullptr;
+    }
 };
 
+static std::string busy_line(long retry_after_ms){
+    return "ERR BUSY retry_after_ms=" + std::to_string(retry_after_ms);
+}
+
+// every answer to a Request goes through here so coalesced flights and
+// batches end
+static void reply(Pipeline* P, const Request& r, std::string text){
+    if (r.batch && r.slot >= 0) {
+        auto& b = *r.batch;
+        b.lines[r.slot] = std::move(text);
+        if (b.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        std::string all = "OK BATCH count=" + std::to_string(b.lines.size());
+        for (auto& l : b.lines) { all += '\n'; all += l; }
+        P->responder.post(Response{r.client_fd, std::move(all), {}, {}, DeadlineClock::now(), r.id});
+        return;
+    }
+    P->responder.post(Response{r.client_fd, std::move(text), r.flight, r.cache_key, DeadlineClock::now(), r.id});
+}
+
 // -------- handlers --------
 static void dispatch_handle(Request&& r, void* ctx){
     auto* P = static_cast<Pipeline*>(ctx);
+    auto now = DeadlineClock::now();
+    P->lat_dispatch->record(now - r.enqueued);
+    trace::record("queue", r.id, r.enqueued, now, "dispatcher");
+    trace::Span span("dispatch", r.id);
+    if (r.deadline != DeadlineClock::time_point{} && DeadlineClock::now() >= r.deadline) {
+        ++P->deadline_dropped;
+        reply(P, r, "ERR DEADLINE");
+        return;
+    }
+    // fan a batch out: one request per algorithm, same graph
+    if (r.batch && r.slot < 0) {
+        auto b = r.batch;
+        b->derived = std::make_shared<DerivedGraph>(r.g);
+        b->remaining.store((int)b->algs.size());
+        for (int i = 0; i < (int)b->algs.size(); ++i) {
+            Request sub;
+            sub.client_fd = r.client_fd; sub.alg = b->algs[i]; sub.g = r.g; sub.labels = r.labels; sub.file_ids = r.file_ids; sub.params = r.params;
+            sub.deadline = r.deadline; sub.batch = b; sub.slot = i; sub.enqueued = now; sub.id = r.id;
+            sub.cost_us = estimate_cost_us(sub.alg, r.g->n, r.g->m, r.params);
+            double c = sub.cost_us;
+            P->stage_for(sub.alg)->post(std::move(sub), c, std::move(r.admitted[i]));
+        }
+        return;
+    }
     // route by algorithm name
-    if (r.alg == "SCC_COUNT")          { P->scc_ao.post(std::move(r)); return; }
-    if (r.alg == "HAM_CYCLE")          { P->ham_ao.post(std::move(r)); return; }
-    if (r.alg == "MAXCLIQUE")          { P->maxclq_ao.post(std::move(r)); return; }
-    if (r.alg == "NUM_MAXCLIQUES")     { P->numclq_ao.post(std::move(r)); return; }
+    if (auto* stage = P->stage_for(r.alg)) {
+        double c = r.cost_us; r.enqueued = now;
+        StageSlot s = std::move(r.admitted[0]);
+        stage->post(std::move(r), c, std::move(s));
+        return;
+    }
     // unknown algorithm
-    Response resp{r.client_fd, "ERR unknown algorithm"};
-    P->responder.post(std::move(resp));
+    reply(P, r, "ERR unknown algorithm");
 }
 
 static void algorithm_run(const char* tag, Request&& r, void* ctx,
@@ -120,87 +188,327 @@ static void algorithm_run(const char* tag, Request&& r, void* ctx,
     auto* P = static_cast<Pipeline*>(ctx);
     std::unique_ptr<IAlgorithm> A(make_algorithm(alg_name));
     if (!A) {
-        P->responder.post(Response{r.client_fd, std::string("ERR unknown algorithm")});
+        reply(P, r, "ERR unknown algorithm");
         return;
     }
-    auto res = A->run(r.g, r.params);
+    // drop if it expired while queued; otherwise run with only the time left
+    if (!apply_remaining(r.params, r.deadline)) {
+        ++P->deadline_dropped;
+        reply(P, r, "ERR DEADLINE");
+        return;
+    }
+    auto t0 = DeadlineClock::now();
+    if (auto* h = P->metrics.find(std::string("queue.") + alg_name)) h->record(t0 - r.enqueued);
+    trace::record("queue", r.id, r.enqueued, t0, alg_name);
+    bool profile = false;
+    if (int pf; kv_get_int(r.params, "profile", pf)) profile = pf != 0;
+    LabelScope ids(r.labels.get(), r.file_ids.get());
+    perf::Scope pc(profile || P->count_all);
+    auto res = r.batch ? run_with_derived(alg_name, *r.batch->derived, r.params) : A->run(*r.g, r.params);
+    auto counted = pc.stop();
+    auto t1 = DeadlineClock::now();
+    P->counters.record(alg_name, counted);
+    if (auto* h = P->metrics.find(std::string("run.") + alg_name)) h->record(t1 - t0);
+    trace::record("run", r.id, t0, t1, alg_name);
     std::string line = std::string("OK ") + alg_name + " " + res.text;
+    if (profile) line += perf::reply_suffix(counted);
     (void)tag; // tag useful if you want logging
-    P->responder.post(Response{r.client_fd, std::move(line)});
+    reply(P, r, std::move(line));
+    arena::trim_scratch();
 }
 static void scc_handle(Request&& r, void* ctx)    { algorithm_run("SCC", std::move(r), ctx, "SCC_COUNT"); }
 static void ham_handle(Request&& r, void* ctx)    { algorithm_run("HAM", std::move(r), ctx, "HAM_CYCLE"); }
 static void maxclq_handle(Request&& r, void* ctx) { algorithm_run("MCQ", std::move(r), ctx, "MAXCLIQUE"); }
 static void numclq_handle(Request&& r, void* ctx) { algorithm_run("NCQ", std::move(r), ctx, "NUM_MAXCLIQUES"); }
 
-static void respond_handle(Response&& resp, void*){
+// a stage refused or shed this request
+static void busy_handle(Request&& r, void* ctx){
+    auto* P = static_cast<Pipeline*>(ctx);
+    auto* stage = P->stage_for(r.alg);
+    reply(P, r, busy_line(stage ? stage->retry_after_ms() : 1));
+}
+
+// "OK STATS dispatcher.depth=.. scc.depth=.. scc.cap=.. ..." (one line)
+static std::string stats_line(Pipeline& P){
+    std::string out = "OK STATS dispatcher.depth=" + std::to_string(P.dispatcher.depth())
+                    + " responder.depth=" + std::to_string(P.responder.depth())
+                    + " deadline_dropped=" + std::to_string(P.deadline_dropped.load())
+                    + " coalesced=" + std::to_string(P.flights.coalesced())
+                    + " pool.steals=" + std::to_string(P.pool.steals());
+    auto g = P.graphs.stats();
+    out += " graphs.hits=" + std::to_string(g.hits) + " graphs.misses=" + std::to_string(g.misses)
+         + " graphs.entries=" + std::to_string(g.entries) + " graphs.bytes=" + std::to_string(g.bytes);
+    const std::pair<const char*, StageExecutor<Request>*> stages[] = {
+        {"scc", &P.scc_ao}, {"ham", &P.ham_ao}, {"maxclq", &P.maxclq_ao}, {"numclq", &P.numclq_ao}};
+    for (auto& [tag, st] : stages) {
+        auto s = st->stats();
+        std::string t = std::string(" ") + tag + ".";
+        out += t+"depth="+std::to_string(s.depth) + t+"cap="+std::to_string(s.capacity)
+             + t+"inflight="+std::to_string(s.inflight) + t+"width="+std::to_string(s.width)
+             + t+"served="+std::to_string(s.served) + t+"rejected="+std::to_string(s.rejected)
+             + t+"shed="+std::to_string(s.shed) + t+"retry_after_ms="+std::to_string(s.retry_after_ms);
+    }
+    return out + P.metrics.text() + P.counters.text();
+}
+
+// STATS JSON: the same numbers as one JSON object
+static std::string stats_json(Pipeline& P){
+    auto g = P.graphs.stats();
+    std::string out = "{\"dispatcher\":{\"depth\":" + std::to_string(P.dispatcher.depth())
+                    + "},\"responder\":{\"depth\":" + std::to_string(P.responder.depth())
+                    + "},\"deadline_dropped\":" + std::to_string(P.deadline_dropped.load())
+                    + ",\"coalesced\":" + std::to_string(P.flights.coalesced())
+                    + ",\"pool\":{\"steals\":" + std::to_string(P.pool.steals()) + "}"
+                    + ",\"graphs\":{\"hits\":" + std::to_string(g.hits) + ",\"misses\":" + std::to_string(g.misses)
+                    + ",\"entries\":" + std::to_string(g.entries) + ",\"bytes\":" + std::to_string(g.bytes) + "},\"stages\":{";
+    const std::pair<const char*, StageExecutor<Request>*> stages[] = {
+        {"scc", &P.scc_ao}, {"ham", &P.ham_ao}, {"maxclq", &P.maxclq_ao}, {"numclq", &P.numclq_ao}};
+    bool first = true;
+    for (auto& [tag, st] : stages) {
+        auto s = st->stats();
+        out += std::string(first ? "" : ",") + "\"" + tag + "\":{\"depth\":" + std::to_string(s.depth)
+             + ",\"cap\":" + std::to_string(s.capacity) + ",\"inflight\":" + std::to_string(s.inflight)
+             + ",\"width\":" + std::to_string(s.width) + ",\"served\":" + std::to_string(s.served)
+             + ",\"rejected\":" + std::to_string(s.rejected) + ",\"shed\":" + std::to_string(s.shed)
+             + ",\"retry_after_ms\":" + std::to_string(s.retry_after_ms) + "}";
+        first = false;
+    }
+    return out + "},\"latency\":" + P.metrics.json() + ",\"perf\":" + P.counters.json() + "}";
+}
+
+// Prometheus exposition: latency summaries plus queue-depth gauges
+static std::string prometheus_text(Pipeline& P){
+    std::string out = P.metrics.prometheus("server9");
+    out += "# TYPE server9_queue_depth gauge\n";
+    out += "server9_queue_depth{queue=\"dispatcher\"} " + std::to_string(P.dispatcher.depth()) + "\n";
+    out += "server9_queue_depth{queue=\"responder\"} " + std::to_string(P.responder.depth()) + "\n";
+    const std::pair<const char*, StageExecutor<Request>*> stages[] = {
+        {"scc", &P.scc_ao}, {"ham", &P.ham_ao}, {"maxclq", &P.maxclq_ao}, {"numclq", &P.numclq_ao}};
+    for (auto& [tag, st] : stages)
+        out += std::string("server9_queue_depth{queue=\"") + tag + "\"} " + std::to_string(st->stats().depth) + "\n";
+    return out;
+}
+
+static void respond_handle(Response&& resp, void* ctx){
+    auto* P = static_cast<Pipeline*>(ctx);
+    auto t0 = DeadlineClock::now();
+    P->lat_respond->record(t0 - resp.enqueued);
+    trace::record("queue", resp.id, resp.enqueued, t0, "responder");
+    if (!resp.cache_key.empty() && cacheable_reply(resp.text)) P->cache.put(resp.cache_key, resp.text);
     if (resp.client_fd >= 0) {
         send_line(resp.client_fd, resp.text);
         close(resp.client_fd);
     }
+    if (!resp.flight.empty())
+        for (int fd : P->flights.finish(resp.flight)) { send_line(fd, resp.text); close(fd); }
+    auto t1 = DeadlineClock::now();
+    P->lat_send->record(t1 - t0);
+    trace::record("send", resp.id, t0, t1);
 }
 
 // -------- request parsing (Stage 7 protocol) --------
-static bool parse_and_build(int cfd, const std::string& firstLine, Request& out){
-    // First tokenized line: "ALG <NAME> RANDOM ..." or "ALG <NAME> GRAPH ..."
-    std::vector<std::string> tok; tok.reserve(16);
-    { std::string cur;
-      for (char ch: firstLine) { if(ch==' '||ch=='\t'){ if(!cur.empty()){ tok.push_back(cur); cur.clear(); } } else cur.push_back(ch); }
-      if(!cur.empty()) tok.push_back(cur);
-    }
-    if (tok.size()<3 || tok[0]!="ALG") { send_line(cfd,"ERR expected 'ALG <NAME> <MODE>'"); return false; }
+// Error: the reply has already been sent. Joined: an identical RANDOM request
+// is in flight and now owns cfd. Cached: the stored reply has been sent.
+enum class Built { Error, Ready, Joined, Cached };
+
+// reorder=..: swap in the permuted graph and keep its id map for the reply.
+// A GRAPH upload belongs to this request and is permuted directly; shared
+// graphs go through P.reorders.
+static Built reordered(Request& out, Reorder order, bool owned, Pipeline& P){
+    if (order == Reorder::None) return Built::Ready;
+    auto p = owned ? reorder_graph(*out.g, order) : P.reorders.get(out.g, order);
+    out.g = GraphRef(p, &p->g);
+    out.labels = std::shared_ptr<const std::vector<int>>(p, &p->to_old);
+    return Built::Ready;
+}
+
+static Built parse_and_build(int cfd, const std::string& firstLine, Request& out, Pipeline& P){
+    // First tokenized line: "ALG <NAME> RANDOM|GRAPH|GRAPHBIN|FILE ..." or "RUN <NAME> <session> ..."
+    // where <NAME> may be "BATCH <A1,A2,...>"; any form takes [reorder=degree|bfs|rcm]
+    auto tok = split_ws(firstLine);
+    if (tok.size()<3 || (tok[0]!="ALG" && tok[0]!="RUN")) { send_line(cfd,"ERR expected 'ALG <NAME> <MODE>' or 'RUN <NAME> <graph>'"); return Built::Error; }
 
     out.client_fd = cfd;
     out.alg = tok[1];
+    if (out.alg=="BATCH") {
+        if (tok.size()<4) { send_line(cfd,"ERR expected 'BATCH <A1,A2,...> <MODE>'"); return Built::Error; }
+        out.batch = std::make_shared<Batch>();
+        std::string a;
+        for (std::size_t i=0; i<=tok[2].size(); ++i) {
+            if (i<tok[2].size() && tok[2][i]!=',') { a.push_back(tok[2][i]); continue; }
+            if (!P.stage_for(a)) { send_line(cfd,"ERR unknown algorithm "+a); return Built::Error; }
+            out.batch->algs.push_back(a); a.clear();
+        }
+        out.batch->lines.resize(out.batch->algs.size());
+        tok.erase(tok.begin()+2);
+    }
+    const bool batch = out.batch != nullptr;
     std::string mode = tok[2];
+
+    // admission control before the graph is built: a queue place in every
+    // stage the request will reach, given back if it ends before the stage
+    for (const auto& a : batch ? out.batch->algs : std::vector<std::string>{out.alg}) {
+        auto* stage = P.stage_for(a);
+        if (!stage) break;   // the dispatcher answers an unknown algorithm
+        if (!stage->admit(out.admitted.emplace_back())) {
+            send_line(cfd, busy_line(stage->retry_after_ms()));
+            return Built::Error;
+        }
+    }
     KV params = kv_from_tokens(std::vector<std::string>(tok.begin()+3, tok.end()));
 
     std::size_t n=0, m=0; int directed=0; unsigned seed=0;
-    if (mode=="RANDOM"){
-        if (!kv_get_size_t(params,"n",n)) { send_line(cfd,"ERR missing n"); return false; }
-        if (!kv_get_size_t(params,"m",m)) { send_line(cfd,"ERR missing m"); return false; }
+    Reorder order = Reorder::None;   // checked before a RANDOM flight is opened
+    if (auto it = params.find("reorder"); it != params.end() && !parse_reorder(it->second, order)) {
+        send_line(cfd, "ERR reorder must be none, degree, bfs or rcm");
+        return Built::Error;
+    }
+    if (tok[0]=="RUN"){
+        auto s = P.sessions.find(mode);
+        if (!s.g) { send_line(cfd,"ERR no such graph"); return Built::Error; }
+        if (std::string known; !batch && answer_from_summary(out.alg, s, known)) { send_line(cfd, known); return Built::Cached; }
+        if (!batch) out.cache_key = result_key(out.alg, "SESSION", params, "s="+std::to_string(s.id));
+        if (std::string hit; !batch && P.cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+        out.g = std::move(s.g);
+        out.cost_us = estimate_cost_us(out.alg, out.g->n, out.g->m, params);
+        out.params = std::move(params);
+        return reordered(out, order, /*owned=*/false, P);
+    } else if (mode=="RANDOM"){
+        if (!kv_get_size_t(params,"n",n)) { send_line(cfd,"ERR missing n"); return Built::Error; }
+        if (!kv_get_size_t(params,"m",m)) { send_line(cfd,"ERR missing m"); return Built::Error; }
         kv_get_int (params,"directed",directed);
         kv_get_uint(params,"seed",seed);
-        Graph g(n, directed!=0);
-        generate_Gnm(g, m, seed);
-        out.g = std::move(g);
-        out.params = std::move(params);
-        return true;
-    } else if (mode=="GRAPH"){
-        if (!kv_get_size_t(params,"n",n)) { send_line(cfd,"ERR missing n"); return false; }
-        if (!kv_get_size_t(params,"m",m)) { send_line(cfd,"ERR missing m"); return false; }
-        kv_get_int(params,"directed",directed);
-        Graph g(n, directed!=0);
-        for (std::size_t i=0;i<m;++i){
-            std::string el;
-            if (!read_line(cfd, el)) { send_line(cfd,"ERR premature end while reading edges"); return false; }
-            int u=-1,v=-1; if (std::sscanf(el.c_str(), "%d %d", &u, &v) != 2) { send_line(cfd,"ERR bad edge format"); return false; }
-            g.add_edge(u, v);
+        if (!batch) {
+            out.cache_key = result_key(out.alg, mode, params);
+            if (std::string hit; P.cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+            std::string key = canonical_request_key(out.alg, mode, params);
+            if (P.flights.join(key, cfd)) return Built::Joined;
+            out.flight = std::move(key);
         }
-        out.g = std::move(g);
+        out.g = P.graphs.get(n, m, seed, directed!=0);
+        out.cost_us = estimate_cost_us(out.alg, n, out.g->m, params);
         out.params = std::move(params);
-        return true;
+        return reordered(out, order, /*owned=*/false, P);
+    } else if (mode=="GRAPH" || mode=="GRAPHBIN"){
+        EdgeHash eh;
+        if (!read_edges(cfd, mode, params, P.upload_cap, out.g, eh)) return Built::Error;
+        if (!batch) out.cache_key = result_key(out.alg, "GRAPH", params, eh.str());
+        if (std::string hit; !batch && P.cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+        out.cost_us = estimate_cost_us(out.alg, out.g->n, out.g->m, params);
+        out.params = std::move(params);
+        return reordered(out, order, /*owned=*/true, P);
+    } else if (mode=="FILE"){
+        std::string version;
+        if (!(out.g = file_graph(cfd, params, P.graphs, P.files_dir, version, &out.file_ids))) return Built::Error;
+        if (!batch) out.cache_key = result_key(out.alg, mode, params, version);
+        if (std::string hit; !batch && P.cache.get(out.cache_key, hit)) { send_line(cfd, hit); return Built::Cached; }
+        out.cost_us = estimate_cost_us(out.alg, out.g->n, out.g->m, params);
+        out.params = std::move(params);
+        return reordered(out, order, /*owned=*/false, P);
     } else {
-        send_line(cfd,"ERR mode must be RANDOM or GRAPH");
-        return false;
+        send_line(cfd,"ERR mode must be RANDOM, GRAPH, GRAPHBIN or FILE");
+        return Built::Error;
     }
 }
 
+// TRACE ON|OFF|CLEAR|DUMP (DUMP replies with Chrome trace JSON on one line)
+static std::string trace_command(const std::string& what){
+    if (what == "ON")    { trace::enable(true);  return "OK TRACE ON"; }
+    if (what == "OFF")   { trace::enable(false); return "OK TRACE OFF"; }
+    if (what == "CLEAR") { trace::clear();       return "OK TRACE CLEARED"; }
+    if (what == "DUMP")  return trace::dump("server9");
+    return "ERR expected 'TRACE ON|OFF|CLEAR|DUMP'";
+}
+
 // -------- main: acceptor + pipeline wiring --------
 static std::atomic<bool> running(true);
 static int listen_fd = -1;
 static void on_sigint(int){ running.store(false); if(listen_fd>=0) close(listen_fd); }
 
 static void usage(const char* p){
-    std::cerr << "Usage: " << p << " -p <port>\n";
+    std::cerr << "Usage: " << p << " -p <port> [-t <pool threads>] [-w <stage widths>] [-q <stage capacities>]\n"
+              << "          [-o block|reject|shed] [-S sejf|fifo] [-C <cache MiB>] [-G <graph cache MiB>]\n"
+              << "          [-M <session quota MiB>] [-U <upload MiB>] [-F <dir>] [-P <metrics port>] [-T] [-H] [-A]\n"
+              << "  -t  worker threads in the shared work-stealing pool (default: hardware threads)\n"
+              << "  -w  max requests in flight per algorithm stage (default: pool size)\n"
+              << "  -q  max queued requests per stage, 0 = unbounded (default: 128)\n"
+              << "  -o  what a full stage does: block the acceptor, reply 'ERR BUSY retry_after_ms=..',\n"
+              << "      or shed its oldest request (default: block)\n"
+              << "  -S  queue order: sejf = shortest expected job first with aging and a fast lane\n"
+              << "      for cheap requests, fifo = arrival order (default: sejf)\n"
+              << "  -C  result cache size in MiB, 0 = off (default: 64); 'CACHE STATS' / 'CACHE CLEAR'\n"
+              << "  -G  generated-graph cache size in MiB, 0 = off (default: 128)\n"
+              << "  -M  memory for graphs stored with 'LOAD <name> GRAPH|GRAPHBIN|RANDOM|FILE ...' and run\n"
+              << "      with 'RUN <ALG> <name> [params]' until 'DROP <name>' (default: 256);\n"
+              << "      'ADD_EDGES|REMOVE_EDGES <name> m=<k>' + k \"u v\" lines make a new version;\n"
+              << "      also caps the memory one LOAD GRAPH/GRAPHBIN upload (from n and m in its header) may need\n"
+              << "  -U  memory one 'ALG ... GRAPH|GRAPHBIN' upload (from n and m in its header) may need,\n"
+              << "      larger ones get ERR QUOTA before anything is read (default: 1024)\n"
+              << "  -F  directory that 'FILE path=..' may read from, relative paths start there\n"
+              << "      (default: none, FILE is refused)\n"
+              << "  -P  serve Prometheus metrics on 127.0.0.1:<port> (default: off); 'STATS' / 'STATS JSON'\n"
+              << "      on the main port report the same latency histograms\n"
+              << "  -T  start with request tracing on ('TRACE ON|OFF|CLEAR|DUMP'; DUMP is Chrome trace JSON)\n"
+              << "  -H  count cycles/instructions/cache and branch misses (perf_event_open) for every\n"
+              << "      algorithm run, totals in 'STATS'; a single request can ask with profile=1\n"
+              << "  -A  plain malloc for algorithm temporaries (default: per-thread scratch pools)\n"
+              << "  stage lists look like 'scc=2,maxclq=4', or a single number for every stage\n";
+}
+
+// "scc=2,maxclq=4" or "4" -> per-stage values; unknown stage names are rejected
+static bool parse_stage_spec(const std::string& spec, std::unordered_map<std::string,int>& w, int min_value){
+    if (!spec.empty() && spec.find('=')==std::string::npos) {
+        for (auto& kv : w) kv.second = std::max(min_value, std::atoi(spec.c_str()));
+        return true;
+    }
+    std::string item;
+    for (std::size_t i=0; i<=spec.size(); ++i){
+        if (i<spec.size() && spec[i]!=',') { item.push_back(spec[i]); continue; }
+        auto eq = item.find('=');
+        if (eq==std::string::npos || !w.count(item.substr(0,eq))) return false;
+        w[item.substr(0,eq)] = std::max(min_value, std::atoi(item.c_str()+eq+1));
+        item.clear();
+    }
+    return true;
 }
 
 int main(int argc, char** argv){
     int port = 5559;
+    int nthreads = std::max(2, (int)std::thread::hardware_concurrency());
+    std::string width_spec, cap_spec, policy_name = "block", sched = "sejf";
+    long cache_mb = 64, graph_mb = 128, session_mb = 256, upload_mb = 1024;
+    std::string file_dir;
+    int metrics_port = 0;
+    bool count_all = false;
     for (int i=1;i<argc;++i){
         if (std::string(argv[i])=="-p" && i+1<argc) port = std::atoi(argv[++i]);
+        else if (std::string(argv[i])=="-t" && i+1<argc) nthreads = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i])=="-w" && i+1<argc) width_spec = argv[++i];
+        else if (std::string(argv[i])=="-q" && i+1<argc) cap_spec = argv[++i];
+        else if (std::string(argv[i])=="-o" && i+1<argc) policy_name = argv[++i];
+        else if (std::string(argv[i])=="-S" && i+1<argc) sched = argv[++i];
+        else if (std::string(argv[i])=="-C" && i+1<argc) cache_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-G" && i+1<argc) graph_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-M" && i+1<argc) session_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-U" && i+1<argc) upload_mb = std::max(0L, std::atol(argv[++i]));
+        else if (std::string(argv[i])=="-F" && i+1<argc) file_dir = argv[++i];
+        else if (std::string(argv[i])=="-P" && i+1<argc) metrics_port = std::atoi(argv[++i]);
+        else if (std::string(argv[i])=="-T") trace::enable(true);
+        else if (std::string(argv[i])=="-H") count_all = true;
+        else if (std::string(argv[i])=="-A") arena::enable(false);
         else { usage(argv[0]); return 2; }
     }
+    std::unordered_map<std::string,int> width{{"scc",nthreads},{"ham",nthreads},{"maxclq",nthreads},{"numclq",nthreads}};
+    std::unordered_map<std::string,int> cap{{"scc",128},{"ham",128},{"maxclq",128},{"numclq",128}};
+    if (!width_spec.empty() && !parse_stage_spec(width_spec, width, 1)) { usage(argv[0]); return 2; }
+    if (!cap_spec.empty() && !parse_stage_spec(cap_spec, cap, 0)) { usage(argv[0]); return 2; }
+    Overload policy;
+    if (policy_name == "block")       policy = Overload::Block;
+    else if (policy_name == "reject") policy = Overload::Reject;
+    else if (policy_name == "shed")   policy = Overload::ShedOldest;
+    else { usage(argv[0]); return 2; }
+    if (sched != "sejf" && sched != "fifo") { usage(argv[0]); return 2; }
+    const bool fifo = sched == "fifo";
     signal(SIGINT, on_sigint);
 
     listen_fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -212,17 +520,42 @@ int main(int argc, char** argv){
     if (listen(listen_fd, 128)<0){ perror("listen"); return 1; }
 
     Pipeline P;
-    P.dispatcher.start(&dispatch_handle, &P, "dispatcher");
-    P.scc_ao.start   (&scc_handle,    &P, "scc");
-    P.ham_ao.start   (&ham_handle,    &P, "ham");
-    P.maxclq_ao.start(&maxclq_handle, &P, "maxclique");
-    P.numclq_ao.start(&numclq_handle, &P, "nummaxcliques");
-    P.responder.start(&respond_handle,&P, "responder");
+    P.cache.resize((std::size_t)cache_mb << 20);
+    P.graphs.resize((std::size_t)graph_mb << 20);
+    P.sessions.set_quota((std::size_t)session_mb << 20);
+    P.upload_cap = (std::size_t)upload_mb << 20;
+    if (!file_dir.empty() && (P.files_dir = file_root(file_dir)).empty()) {
+        std::cerr << "-F: no such directory " << file_dir << "\n";
+        return 2;
+    }
+    P.init_metrics();
+    P.count_all = count_all;
+    if (metrics_port > 0 && !serve_prometheus(metrics_port, [&P]{ return prometheus_text(P); }))
+        std::cerr << "metrics: cannot listen on 127.0.0.1:" << metrics_port << "\n";
+    // SEJF keeps one worker for the fast lane when there is more than one
+    P.pool.start(nthreads, fifo ? 0 : 1);
+    P.dispatcher.start({}, &P, "dispatcher");
+    P.scc_ao.start   (&P.pool, width["scc"],    &scc_handle,    &P, "scc");
+    P.ham_ao.start   (&P.pool, width["ham"],    &ham_handle,    &P, "ham");
+    P.maxclq_ao.start(&P.pool, width["maxclq"], &maxclq_handle, &P, "maxclique");
+    P.numclq_ao.start(&P.pool, width["numclq"], &numclq_handle, &P, "nummaxcliques");
+    P.scc_ao.limit   ((std::size_t)cap["scc"],    policy, &busy_handle);
+    P.ham_ao.limit   ((std::size_t)cap["ham"],    policy, &busy_handle);
+    P.maxclq_ao.limit((std::size_t)cap["maxclq"], policy, &busy_handle);
+    P.numclq_ao.limit((std::size_t)cap["numclq"], policy, &busy_handle);
+    for (auto* st : {&P.scc_ao, &P.ham_ao, &P.maxclq_ao, &P.numclq_ao}) st->schedule(1.0, fifo);
+    P.responder.start({}, &P, "responder");
 
     std::cout << "Stage9 Pipeline server listening on port " << port
-              << " (Active Objects: dispatcher + 4 algos + responder)\n";
+              << " (dispatcher + 4 algo stages on " << nthreads << " stealing workers"
+              << " [scc=" << width["scc"] << " ham=" << width["ham"]
+              << " maxclq=" << width["maxclq"] << " numclq=" << width["numclq"]
+              << "] + responder, queue cap scc=" << cap["scc"] << " ham=" << cap["ham"]
+              << " maxclq=" << cap["maxclq"] << " numclq=" << cap["numclq"] << " policy=" << policy_name
+              << ", " << sched << " order)\n";
 
     // single acceptor (can be extended to multiple if you like)
+    std::uint64_t next_id = 0;
     while (running.load()) {
         sockaddr_in cli{}; socklen_t cl = sizeof(cli);
         int cfd = accept(listen_fd, (sockaddr*)&cli, &cl);
@@ -230,27 +563,39 @@ int main(int argc, char** argv){
             if (!running.load()) break;
             continue;
         }
+        auto accepted = DeadlineClock::now();
         // Read single-line request, then possibly m edge lines (GRAPH)
         std::string first;
         if (!read_line(cfd, first)) { close(cfd); continue; }
 
+        if (first == "STATS") { send_line(cfd, stats_line(P)); close(cfd); continue; }
+        if (first == "STATS JSON") { send_line(cfd, stats_json(P)); close(cfd); continue; }
+        if (first.rfind("TRACE ", 0) == 0) { send_line(cfd, trace_command(first.substr(6))); close(cfd); continue; }
+        if (session_command(cfd, first, P.sessions, P.graphs, P.files_dir)) { close(cfd); continue; }
+        if (first == "CACHE STATS") { send_line(cfd, P.cache.stats_line()); close(cfd); continue; }
+        if (first == "CACHE CLEAR") { P.cache.clear(); P.graphs.clear(); P.reorders.clear(); send_line(cfd, "OK CACHE CLEARED"); close(cfd); continue; }
+
         Request r;
-        if (!parse_and_build(cfd, first, r)) {
+        Built b = parse_and_build(cfd, first, r, P);
+        if (b == Built::Error || b == Built::Cached) {
             // parse function already sent error line
             close(cfd);
             continue;
         }
+        if (b == Built::Joined) continue;   // the flight leader's reply covers it
+        r.deadline = deadline_from(r.params, accepted);
+        r.enqueued = DeadlineClock::now();
+        r.id = ++next_id;
+        P.lat_parse->record(r.enqueued - accepted);
+        trace::record("accept_parse", r.id, accepted, r.enqueued);
         // push into pipeline at the dispatcher
         P.dispatcher.post(std::move(r));
         // responder will close cfd
     }
 
-    // graceful stop
+    // graceful stop (the pool drains every stage before joining)
     P.dispatcher.stop();
-    P.scc_ao.stop();
-    P.ham_ao.stop();
-    P.maxclq_ao.stop();
-    P.numclq_ao.stop();
+    P.pool.stop();
     P.responder.stop();
 
     return 0;
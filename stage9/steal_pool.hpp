@@ -0,0 +1,393 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sched.hpp"   // ../stage7: SejfQueue, kFastLaneUs
+
+// Chase–Lev work-stealing deque (Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", 2013). The owner pushes/pops at the
+// bottom, thieves steal from the top. T must be trivially copyable (we store
+// Task pointers).
+template <typename T>
+class ChaseLevDeque {
+public:
+    explicit ChaseLevDeque(std::size_t cap = 64) : arr_(new Array(cap)) {}
+    ~ChaseLevDeque(){ delete arr_.load(std::memory_order_relaxed); }
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // owner only
+    void push(T x) {
+        long b = bottom_.load(std::memory_order_relaxed);
+        long t = top_.load(std::memory_order_acquire);
+        Array* a = arr_.load(std::memory_order_relaxed);
+        if (b - t > (long)a->cap - 1) a = grow(a, t, b);
+        a->put(b, x);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    // owner only
+    bool pop(T& out) {
+        long b = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* a = arr_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long t = top_.load(std::memory_order_relaxed);
+        if (t > b) { bottom_.store(b + 1, std::memory_order_relaxed); return false; }
+        out = a->get(b);
+        if (t == b) { // last element: race against thieves
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+    // any thread
+    bool steal(T& out) {
+        long t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Array* a = arr_.load(std::memory_order_acquire);
+        out = a->get(t);
+        return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        std::size_t cap;
+        std::unique_ptr<std::atomic<T>[]> buf;
+        explicit Array(std::size_t c) : cap(c), buf(new std::atomic<T>[c]) {}
+        T get(long i) const { return buf[(std::size_t)i & (cap - 1)].load(std::memory_order_relaxed); }
+        void put(long i, T x) { buf[(std::size_t)i & (cap - 1)].store(x, std::memory_order_relaxed); }
+    };
+    Array* grow(Array* a, long t, long b) {
+        Array* na = new Array(a->cap * 2);
+        for (long i = t; i < b; ++i) na->put(i, a->get(i));
+        arr_.store(na, std::memory_order_release);
+        retired_.emplace_back(a); // thieves may still read the old array
+        return na;
+    }
+
+    alignas(64) std::atomic<long> top_{0};
+    alignas(64) std::atomic<long> bottom_{0};
+    std::atomic<Array*> arr_;
+    std::vector<std::unique_ptr<Array>> retired_; // owner only
+};
+
+// Fixed set of workers, each owning a Chase–Lev deque. Tasks submitted from a
+// worker go to its own deque unless submitted with local=false; tasks from
+// other threads go through a shared FIFO injection queue. A worker that takes
+// from the injection queue moves its share of the backlog (up to kGrab tasks)
+// onto its own deque, where idle workers steal it; a worker looks at its own
+// deque, then steals, then takes from the injection queue, so grabbed tasks
+// (older than anything still injected) run first.
+// Fast-lane tasks (cheap requests) sit in their own queue that every worker
+// checks first; the first `reserved` workers serve only that lane, so cheap
+// work always has a thread even when every other worker is busy on NP-hard
+// jobs.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+    static constexpr std::size_t kGrab = 8;
+
+    WorkStealingPool() = default;
+    ~WorkStealingPool(){ stop(); }
+
+    void start(int nthreads, int reserved = 0) {
+        reserved_ = std::max(0, std::min(reserved, nthreads - 1));
+        running_.store(true);
+        for (int i = 0; i < nthreads; ++i) workers_.emplace_back(new Worker);
+        for (int i = 0; i < nthreads; ++i)
+            workers_[i]->thr = std::thread([this, i]{ loop(i); });
+    }
+    int size() const { return (int)workers_.size(); }
+    int reserved() const { return reserved_; }
+    // tasks taken from another worker's deque so far
+    unsigned long long steals() const { return steals_.load(std::memory_order_relaxed); }
+
+    void submit(Task t, bool fast = false, bool local = true) {
+        Task* p = new Task(std::move(t));
+        if (fast) {
+            { std::lock_guard<std::mutex> lk(inject_m_); fast_.push_back(p); }
+            fast_pending_.fetch_add(1);
+        } else if (local && tl_pool_ == this && tl_index_ >= reserved_) {
+            workers_[tl_index_]->dq.push(p);
+        } else {
+            std::lock_guard<std::mutex> lk(inject_m_); inject_.push_back(p);
+        }
+        pending_.fetch_add(1);
+        if (fast && fidle_.load() > 0) { std::lock_guard<std::mutex> lk(m_); fcv_.notify_one(); }
+        else if (idle_.load() > 0)     { std::lock_guard<std::mutex> lk(m_); cv_.notify_one(); }
+    }
+
+    // Workers finish every queued task before exiting.
+    void stop() {
+        bool expected = true;
+        if (!running_.compare_exchange_strong(expected, false)) return;
+        { std::lock_guard<std::mutex> lk(m_); cv_.notify_all(); fcv_.notify_all(); }
+        for (auto& w : workers_) if (w->thr.joinable()) w->thr.join();
+    }
+
+private:
+    struct Worker {
+        ChaseLevDeque<Task*> dq;
+        std::thread thr;
+    };
+
+    Task* find(int self, std::minstd_rand& rng) {
+        Task* t = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(inject_m_);
+            if (!fast_.empty()) { t = fast_.front(); fast_.pop_front(); fast_pending_.fetch_sub(1); return t; }
+            if (self < reserved_) return nullptr;
+        }
+        auto& dq = workers_[self]->dq;
+        if (dq.pop(t)) return t;
+        const int n = (int)workers_.size();
+        const int start = n > 1 ? (int)(rng() % n) : 0;
+        for (int k = 0; k < n; ++k) {
+            int v = (start + k) % n;
+            if (v != self && v >= reserved_ && workers_[v]->dq.steal(t)) {
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return t;
+            }
+        }
+        Task* grab[kGrab];
+        std::size_t k = 0;
+        {
+            std::lock_guard<std::mutex> lk(inject_m_);
+            if (inject_.empty()) return nullptr;
+            std::size_t share = std::min(kGrab, inject_.size() / (std::size_t)(n - reserved_) + 1);
+            for (; k < share; ++k) { grab[k] = inject_.front(); inject_.pop_front(); }
+        }
+        // newest first, so the owner pops them in arrival order and thieves
+        // take the newest
+        while (k > 1) dq.push(grab[--k]);
+        return grab[0];
+    }
+
+    void loop(int self) {
+        tl_pool_ = this; tl_index_ = self;
+        std::minstd_rand rng((unsigned)self + 1);
+        const bool lane = self < reserved_;
+        auto& cv = lane ? fcv_ : cv_;
+        auto& idle = lane ? fidle_ : idle_;
+        auto& pending = lane ? fast_pending_ : pending_;
+        while (true) {
+            if (Task* t = find(self, rng)) {
+                pending_.fetch_sub(1);
+                (*t)();
+                delete t;
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(m_);
+            if (!running_.load() && pending.load() == 0) break;
+            idle.fetch_add(1);
+            cv.wait(lk, [&]{ return pending.load() > 0 || !running_.load(); });
+            idle.fetch_sub(1);
+        }
+        tl_pool_ = nullptr;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    int reserved_{0};
+    std::mutex inject_m_;
+    std::deque<Task*> inject_, fast_;
+    std::mutex m_;
+    std::condition_variable cv_, fcv_;
+    std::atomic<long> pending_{0};      // submitted but not yet picked up
+    std::atomic<long> fast_pending_{0}; // of those, fast-lane tasks
+    std::atomic<int> idle_{0}, fidle_{0}; // workers parked on cv_ / fcv_
+    std::atomic<unsigned long long> steals_{0};
+    std::atomic<bool> running_{false};
+
+    static inline thread_local WorkStealingPool* tl_pool_ = nullptr;
+    static inline thread_local int tl_index_ = -1;
+};
+
+// What a full stage does with one more request.
+enum class Overload {
+    Block,       // make admit() wait for room (backpressure to the acceptor)
+    Reject,      // refuse the new request
+    ShedOldest,  // drop the oldest queued request to make room
+};
+
+// A queue place reserved by StageExecutor::admit() and used up by post();
+// dropping an unused one (error reply, cache hit, deadline) gives it back.
+class StageSlot {
+public:
+    StageSlot() = default;
+    StageSlot(StageSlot&& o) noexcept : owner_(std::exchange(o.owner_, nullptr)), release_(o.release_) {}
+    StageSlot& operator=(StageSlot&& o) noexcept {
+        if (this != &o) { reset(); owner_ = std::exchange(o.owner_, nullptr); release_ = o.release_; }
+        return *this;
+    }
+    ~StageSlot() { reset(); }
+    void reset() { if (owner_) release_(std::exchange(owner_, nullptr)); }
+
+private:
+    template <typename> friend class StageExecutor;
+    StageSlot(void* owner, void (*release)(void*)) : owner_(owner), release_(release) {}
+    void* owner_{nullptr};
+    void (*release_)(void*){nullptr};
+};
+
+// A pipeline stage that runs on a shared WorkStealingPool with at most `width`
+// items in flight. Each pool task handles one item and, if more are queued,
+// resubmits itself, so wide stages cannot monopolise the pool.
+// Queued items are served shortest-expected-job-first with aging; a task whose
+// next item is cheap goes to the pool's fast lane.
+// With a capacity set, at most `capacity` items wait in the queue; rejected or
+// shed items are handed to the drop handler so the client can be answered.
+template <typename T>
+class StageExecutor {
+public:
+    using Handler = void(*)(T&&, void*);
+
+    struct Stats {
+        std::size_t depth, capacity;
+        int inflight, width;
+        unsigned long long served, rejected, shed;
+        long retry_after_ms;
+    };
+
+    void start(WorkStealingPool* pool, int width, Handler h, void* ctx, const char* name = nullptr) {
+        pool_ = pool; width_ = width < 1 ? 1 : width; handler_ = h; ctx_ = ctx; name_ = name;
+    }
+    void schedule(double aging, bool fifo) {
+        std::lock_guard<std::mutex> lk(m_);
+        q_.configure(aging, fifo);
+    }
+    // capacity 0 = unbounded
+    void limit(std::size_t capacity, Overload policy, Handler on_drop) {
+        std::lock_guard<std::mutex> lk(m_);
+        cap_ = capacity; policy_ = policy; on_drop_ = on_drop;
+    }
+
+    // Cheap check before a request is built (e.g. before its graph is
+    // generated): false means it would be rejected. Otherwise `slot` holds a
+    // queue place for the request's post(); under Overload::Block this waits
+    // for one. ShedOldest reserves nothing, post() makes room.
+    bool admit(StageSlot& slot) {
+        std::unique_lock<std::mutex> lk(m_);
+        if (policy_ == Overload::ShedOldest) return true;
+        if (full()) {
+            if (policy_ == Overload::Reject) { ++rejected_; return false; }
+            room_.wait(lk, [&]{ return !full(); });
+        }
+        ++reserved_;
+        slot = StageSlot(this, &StageExecutor::unreserve);
+        return true;
+    }
+
+    // Never waits: an item with a slot from admit() always fits, one without
+    // is rejected or sheds the oldest when the stage is full (under Block it
+    // is queued anyway, the acceptor already waited).
+    void post(T item, double cost_us, StageSlot slot = {}) {
+        T dropped; bool drop = false;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            if (slot.owner_ == this) { slot.owner_ = nullptr; --reserved_; }
+            else if (full() && policy_ == Overload::Reject) { ++rejected_; dropped = std::move(item); drop = true; }
+            else if (full() && policy_ == Overload::ShedOldest) { ++shed_; dropped = q_.pop_oldest(); drop = true; }
+            if (!(drop && policy_ == Overload::Reject)) {
+                q_.push(std::move(item), cost_us);
+                // a shed item's replacement is already claimed by a task
+                if (inflight_ < width_ && q_.size() > (std::size_t)unpopped_) {
+                    ++inflight_; ++unpopped_;
+                    bool fast = next_is_fast();
+                    lk.unlock();
+                    submit(fast);
+                }
+            }
+        }
+        if (drop && on_drop_) on_drop_(std::move(dropped), ctx_);
+    }
+
+    // Rough time until a new request would start: queued work spread over the
+    // stage width, at the recent average service time.
+    long retry_after_ms() {
+        std::lock_guard<std::mutex> lk(m_);
+        return retry_after_locked();
+    }
+    Stats stats() {
+        std::lock_guard<std::mutex> lk(m_);
+        return {q_.size(), cap_, inflight_, width_, served_, rejected_, shed_, retry_after_locked()};
+    }
+    int width() const { return width_; }
+    const char* name() const { return name_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool full() const { return cap_ && q_.size() + reserved_ >= cap_; }
+    static void unreserve(void* self) {
+        auto* st = static_cast<StageExecutor*>(self);
+        { std::lock_guard<std::mutex> lk(st->m_); --st->reserved_; }
+        st->room_.notify_all();
+    }
+    bool next_is_fast() const { return !q_.fifo() && !q_.empty() && q_.top_cost() < kFastLaneUs; }
+    // through the injection queue even from a worker: a stage's follow-up task
+    // queues behind other stages' work instead of on top of its own deque
+    void submit(bool fast) { pool_->submit([this, fast]{ run_one(fast); }, fast, /*local=*/false); }
+    long retry_after_locked() const {
+        double ms = avg_us_ / 1000.0 * (double)(q_.size() + 1) / width_;
+        return std::max(1L, (long)ms);
+    }
+
+    void run_one(bool fast) {
+        T item;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            // a fast-lane task must not pick up an expensive job (aging may
+            // have moved one to the top); hand the turn to a normal worker
+            if (fast && !next_is_fast()) { lk.unlock(); submit(false); return; }
+            item = q_.pop();
+            --unpopped_;
+        }
+        room_.notify_all();
+        auto t0 = Clock::now();
+        if (handler_) handler_(std::move(item), ctx_);
+        double us = (double)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            ++served_;
+            avg_us_ = served_ == 1 ? us : 0.8 * avg_us_ + 0.2 * us;   // EWMA
+            // items not yet claimed by an already-submitted task?
+            if (q_.size() <= (std::size_t)unpopped_) { --inflight_; return; }
+            ++unpopped_;
+            fast = next_is_fast();
+        }
+        submit(fast);
+    }
+
+    WorkStealingPool* pool_{nullptr};
+    std::mutex m_;
+    std::condition_variable room_;   // admit() waits here under Block
+    SejfQueue<T> q_;
+    int inflight_{0};   // tasks submitted and not yet finished (<= width_)
+    int unpopped_{0};   // of those, tasks that have not taken their item yet
+    std::size_t reserved_{0};   // slots admitted and not yet posted
+    int width_{1};
+    std::size_t cap_{0};
+    Overload policy_{Overload::Block};
+    unsigned long long served_{0}, rejected_{0}, shed_{0};
+    double avg_us_{0};
+    Handler handler_{nullptr};
+    Handler on_drop_{nullptr};
+    void* ctx_{nullptr};
+    const char* name_{nullptr};
+};